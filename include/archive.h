@@ -0,0 +1,199 @@
+/*
+ * archive.h
+ *
+ * Bounded archive of the best distinct solutions found so far. Decode threads publish into it
+ * as they finish, and any thread (another island, a refinement stage, the caller between
+ * generations) can read the current top-k without stopping them.
+ *
+ * Each slot is guarded by a sequence counter (a seqlock): a publisher claims a slot by moving
+ * its counter from even to odd with a CAS, writes it and makes the counter even again; readers
+ * copy a slot and retry if the counter moved meanwhile. No thread ever waits on a lock, and
+ * every field is an atomic, so torn reads are detected rather than undefined.
+ *
+ * Replacement is diversity-aware: a solution whose signature (see Decoder::signature) is
+ * already archived only replaces that entry, and only if it is better; a new signature replaces
+ * the worst entry. Fitness is minimized, as in BRKGA.
+ */
+
+#ifndef ARCHIVE_H
+#define ARCHIVE_H
+
+#include <vector>
+#include <atomic>
+#include <limits>
+#include <memory>
+#include <algorithm>
+#include <unordered_set>
+#include <stdexcept>
+
+struct ArchiveEntry {
+	double fitness;
+	unsigned long long signature;
+	std::vector< double > chromosome;
+};
+
+class EliteArchive {
+public:
+	EliteArchive(unsigned n, unsigned capacity);
+
+	// Cheap test before computing a signature: false if 'fitness' cannot enter the archive now
+	bool admits(double fitness) const;
+
+	// Offers a decoded chromosome of n alleles; returns whether it was archived
+	bool publish(double fitness, unsigned long long signature, const double* chromosome);
+
+	// The best k entries, best first (a consistent copy of each entry, not of the whole archive)
+	std::vector< ArchiveEntry > top(unsigned k) const;
+
+	unsigned getN() const;
+	unsigned getCapacity() const;
+	unsigned long long getAccepted() const;	// publish() calls that archived their chromosome
+
+private:
+	struct Slot {
+		std::atomic< unsigned long long > version;		// odd while a publisher writes the slot
+		std::atomic< double > fitness;					// +infinity while empty
+		std::atomic< unsigned long long > signature;
+	};
+
+	const unsigned n;
+	const unsigned capacity;
+	std::unique_ptr< Slot[] > slots;
+	std::unique_ptr< std::atomic< double >[] > genes;	// 'capacity' rows of n alleles
+
+	// Fitness of the worst entry (+infinity while a slot is empty). Entries are only ever replaced
+	// by better ones, so it never increases; a stale value only lets a few more candidates in.
+	std::atomic< double > threshold;
+	std::atomic< unsigned long long > accepted;
+
+	bool read(unsigned i, ArchiveEntry& entry) const;	// false if slot i is empty
+	void lowerThreshold();
+};
+
+inline EliteArchive::EliteArchive(unsigned _n, unsigned _capacity) : n(_n), capacity(_capacity),
+		slots(new Slot[_capacity]), genes(new std::atomic< double >[std::size_t(_n) * _capacity]),
+		threshold(std::numeric_limits< double >::infinity()), accepted(0) {
+	if(n == 0) { throw std::range_error("Chromosome size equals zero."); }
+	if(capacity == 0) { throw std::range_error("Archive capacity equals zero."); }
+
+	for(unsigned i = 0; i < capacity; ++i) {
+		slots[i].version.store(0, std::memory_order_relaxed);
+		slots[i].fitness.store(std::numeric_limits< double >::infinity(), std::memory_order_relaxed);
+		slots[i].signature.store(0, std::memory_order_relaxed);
+	}
+	for(std::size_t j = 0; j < std::size_t(n) * capacity; ++j) { genes[j].store(0.0, std::memory_order_relaxed); }
+}
+
+inline bool EliteArchive::admits(double fitness) const {
+	return fitness < threshold.load(std::memory_order_relaxed);
+}
+
+inline bool EliteArchive::publish(double fitness, unsigned long long signature, const double* chromosome) {
+	while(admits(fitness)) {
+		// Victim: the entry with our signature if there is one, the worst entry otherwise
+		unsigned victim = capacity;
+		bool same = false;
+		double victimFitness = -std::numeric_limits< double >::infinity();
+		for(unsigned i = 0; i < capacity; ++i) {
+			const double f = slots[i].fitness.load(std::memory_order_relaxed);
+			if(f != std::numeric_limits< double >::infinity() &&
+					slots[i].signature.load(std::memory_order_relaxed) == signature) {
+				victim = i;
+				victimFitness = f;
+				same = true;
+				break;
+			}
+			if(f > victimFitness) { victim = i; victimFitness = f; }
+		}
+		if(fitness >= victimFitness) { return false; }
+
+		Slot& slot = slots[victim];
+		unsigned long long version = slot.version.load(std::memory_order_relaxed);
+		if((version & 1) != 0 || !slot.version.compare_exchange_strong(version, version + 1,
+				std::memory_order_acquire, std::memory_order_relaxed)) {
+			continue;	// another publisher holds it: look again
+		}
+		std::atomic_thread_fence(std::memory_order_release);
+
+		// The slot may have changed between the scan and the claim
+		const double current = slot.fitness.load(std::memory_order_relaxed);
+		const bool stillSame = current != std::numeric_limits< double >::infinity() &&
+				slot.signature.load(std::memory_order_relaxed) == signature;
+		if(fitness >= current || same != stillSame) {
+			slot.version.store(version + 2, std::memory_order_release);
+			continue;
+		}
+
+		std::atomic< double >* row = &genes[std::size_t(victim) * n];
+		for(unsigned j = 0; j < n; ++j) { row[j].store(chromosome[j], std::memory_order_relaxed); }
+		slot.signature.store(signature, std::memory_order_relaxed);
+		slot.fitness.store(fitness, std::memory_order_relaxed);
+		slot.version.store(version + 2, std::memory_order_release);
+
+		accepted.fetch_add(1, std::memory_order_relaxed);
+		lowerThreshold();
+		return true;
+	}
+
+	return false;
+}
+
+inline bool EliteArchive::read(unsigned i, ArchiveEntry& entry) const {
+	const Slot& slot = slots[i];
+	const std::atomic< double >* row = &genes[std::size_t(i) * n];
+	entry.chromosome.resize(n);
+
+	while(true) {
+		const unsigned long long before = slot.version.load(std::memory_order_acquire);
+		if((before & 1) != 0) { continue; }
+
+		entry.fitness = slot.fitness.load(std::memory_order_relaxed);
+		entry.signature = slot.signature.load(std::memory_order_relaxed);
+		for(unsigned j = 0; j < n; ++j) { entry.chromosome[j] = row[j].load(std::memory_order_relaxed); }
+
+		std::atomic_thread_fence(std::memory_order_acquire);
+		if(slot.version.load(std::memory_order_relaxed) == before) { break; }
+	}
+
+	return entry.fitness != std::numeric_limits< double >::infinity();
+}
+
+inline std::vector< ArchiveEntry > EliteArchive::top(unsigned k) const {
+	std::vector< ArchiveEntry > entries;
+	ArchiveEntry entry;
+	for(unsigned i = 0; i < capacity; ++i) {
+		if(read(i, entry)) { entries.push_back(entry); }
+	}
+
+	std::sort(entries.begin(), entries.end(),
+			[](const ArchiveEntry& a, const ArchiveEntry& b) { return a.fitness < b.fitness; });
+
+	// Two publishers racing on a new signature may both have archived it; keep the better copy
+	std::vector< ArchiveEntry > best;
+	std::unordered_set< unsigned long long > seen;
+	for(ArchiveEntry& e : entries) {
+		if(best.size() == k) { break; }
+		if(seen.insert(e.signature).second) { best.push_back(std::move(e)); }
+	}
+
+	return best;
+}
+
+inline void EliteArchive::lowerThreshold() {
+	double worst = -std::numeric_limits< double >::infinity();
+	for(unsigned i = 0; i < capacity; ++i) {
+		worst = std::max(worst, slots[i].fitness.load(std::memory_order_relaxed));
+	}
+
+	// Only ever lower it: a concurrent, staler scan must not raise it back
+	double current = threshold.load(std::memory_order_relaxed);
+	while(worst < current && !threshold.compare_exchange_weak(current, worst, std::memory_order_relaxed)) {}
+}
+
+inline unsigned EliteArchive::getN() const { return n; }
+
+inline unsigned EliteArchive::getCapacity() const { return capacity; }
+
+inline unsigned long long EliteArchive::getAccepted() const { return accepted.load(std::memory_order_relaxed); }
+
+#endif
@@ -9,6 +9,19 @@
  * - evolve() operator: evolve each Population following the BRKGA methodology. This method
  *                      supports OpenMP to evolve up to K independent Populations in parallel.
  *                      Please note that double Decoder::decode(...) MUST be thread-safe.
+ *                      With K > 1, the K islands evolve concurrently, each one decoding with its
+ *                      own slice of MAX_THREADS / K threads (nested OpenMP), and synchronize only
+ *                      to migrate elite chromosomes (see setMigration).
+ * - evolveSteadyState(): asynchronous alternative to evolve() without generation barriers.
+ * - setRestart(): partial restarts of populations that stop improving, logged as RestartEvent.
+ * - pathRelink(): implicit path relinking between two elite chromosomes.
+ * - injectChromosomes(): warm start from known chromosomes.
+ * - saveCheckpoint() / loadCheckpoint(): binary snapshot of the whole state, to resume a run.
+ * - setMultiParent(): multi-parent biased crossover (BRKGA-MP, Andrade et al. 2021) instead of the
+ *                     classic elite x non-elite mating.
+ * - setArchive(): every decode is offered to a shared EliteArchive of distinct best solutions.
+ * - setAdaptiveSize(): p follows the progress and diversity of the search, within bounds.
+ * - setParameterControl(): rhoe and pm adapted every generation from population statistics.
  *
  * Required hyperparameters:
  * - n: number of genes in each chromosome
@@ -22,12 +35,19 @@
  * - MAX_THREADS: number of threads to perform parallel decoding -- WARNING: Decoder::decode() MUST
  *                be thread-safe!
  *
+ * Offspring and mutants are generated in parallel with a counter-based generator (Philox) keyed by
+ * (seed, generation, individual), where the seed is drawn once from RNG at construction. Given the
+ * same RNG seed, the populations are thus identical for any MAX_THREADS, as long as decoding is
+ * deterministic.
+ *
  * Required templates are:
  * RNG: random number generator that implements the methods below.
  *     - RNG(unsigned long seed) to initialize a new RNG with 'seed'
  *     - double rand() to return a double precision random deviate in range [0,1)
  *     - unsigned long randInt() to return a >=32-bit unsigned random deviate in range [0,2^32-1)
  *     - unsigned long randInt(N) to return a unsigned random deviate in range [0, N] with N < 2^32
+ *     - save(uint32*) / load(uint32*) of its state in an array of RNG::SAVE RNG::uint32 words
+ *       (32-bit values), for checkpoints
  *
  * Decoder: problem-specific decoder that implements any of the decode methods outlined below. When
  *          compiling and linking BRKGA with -fopenmp (i.e., with multithreading support via
@@ -35,6 +55,15 @@
  *     - double decode(const vector< double >& chromosome) const, if you don't want to change
  *       chromosomes inside the framework, or
  *     - double decode(vector< double >& chromosome) const, if you'd like to update a chromosome
+ *     - double intensify(vector< double >& chromosome) const, the expensive refinement applied only
+ *       to the top-k chromosomes when setIntensification(k) is enabled
+ *     - double cost(const vector< double >& chromosome) const, a cheap estimate of the time
+ *       decode() will take on 'chromosome' (any unit); decodes are dispatched longest-first
+ *     - unsigned long long signature(const vector< double >& chromosome) const, equal for
+ *       chromosomes that decode to the same solution (used by setDuplicateElimination and
+ *       setArchive)
+ *     Chromosomes are stored flat (see Population), so each thread decodes a private copy of the
+ *     chromosome and writes it back afterwards.
  *
  *  Created on : Jun 22, 2010 by rtoso
  *  Last update: Sep 28, 2010 by rtoso
@@ -46,12 +75,63 @@
 
 #include <omp.h>
 #include <algorithm>
+#include <cmath>
+#include <atomic>
+#include <unordered_set>
+#include <mutex>
+#include <cstdio>
+#include <string>
 #include <exception>
 #include <stdexcept>
 #include "../include/population.h"
+#include "../include/archive.h"
+#include "../include/philox.h"
 
 ll evaluations = 0;
 
+// Which islands send their elite to which at each migration (see BRKGA::setMigration):
+enum class MigrationTopology {
+	ALL_TO_ALL,	// every island receives from every other one (the classic exchangeElite)
+	RING,		// island i receives from island i - 1
+	TORUS,		// islands on a rows x cols grid receive from their 4 wrap-around neighbors
+	RANDOM		// each island receives from one island drawn at every migration
+};
+
+// Weight of the parent of rank r = 1, 2, ... in multi-parent crossover (see BRKGA::setMultiParent):
+enum class BiasFunction {
+	CONSTANT,		// 1
+	LINEAR,			// 1 / r
+	QUADRATIC,		// 1 / r^2
+	CUBIC,			// 1 / r^3
+	EXPONENTIAL,	// e^-r
+	LOGINVERSE		// 1 / log(r + 1)
+};
+
+// Population size change made by setAdaptiveSize, with the statistics that triggered it
+struct ResizeEvent {
+	unsigned generation;	// generations evolved when p changed
+	unsigned p;				// new population size
+	double diversity;		// mean allele standard deviation, relative to a random population
+	double gain;			// relative improvement of the best fitness over the last window
+};
+
+// Statistics and parameters after a generation of evolve(), logged by setParameterControl
+struct GenerationStats {
+	unsigned generation;	// generations evolved
+	unsigned p;				// population size
+	double rhoe;			// rhoe for the next generation
+	double pm;				// mutant share of p for the next generation
+	double diversity;		// as in ResizeEvent, averaged over the populations
+	double success;			// moving average of the generations that improved the mean elite fitness
+};
+
+// A partial restart triggered by stagnation (see BRKGA::setRestart):
+struct RestartEvent {
+	unsigned generation;	// generations evolved when the population was restarted
+	unsigned population;
+	double bestFitness;		// best fitness kept across the restart
+};
+
 template< class Decoder, class RNG >
 class BRKGA {
 public:
@@ -91,24 +171,148 @@ public:
 	 */
 	void evolve(unsigned generations = 1);
 
+	/**
+	 * Asynchronous steady-state evolution of population k: every thread repeatedly mates two
+	 * parents (or draws a mutant, with probability pm / p), decodes the offspring and inserts it
+	 * in place of the worst chromosome if it is better, keeping the population ranked throughout.
+	 * Threads never wait for each other at a barrier, at the price of run-to-run reproducibility
+	 * (the outcome depends on the order in which decodes finish). Intensification is not applied.
+	 * @param offspring number of chromosomes to generate and decode
+	 * @param k population to evolve
+	 */
+	void evolveSteadyState(unsigned offspring, unsigned k = 0);
+
 	/**
 	 * Exchange elite-solutions between the populations
 	 * @param M number of elite chromosomes to select from each population
 	 */
 	void exchangeElite(unsigned M);
 
+	/**
+	 * Puts already decoded migrants (fitness, chromosome) from another process in place of the
+	 * worst chromosomes of population k, as exchangeElite() does between local populations
+	 */
+	void importElite(const std::vector< std::pair< double, std::vector< double > > >& migrants, unsigned k = 0);
+
+	/**
+	 * Decodes the given chromosomes (alleles are clamped to [0,1)) and puts them in place of the
+	 * worst chromosomes of population k, e.g., to start from the solutions of a previous run
+	 * @param chromosomes at most p chromosomes of n alleles each
+	 */
+	void injectChromosomes(const std::vector< std::vector< double > >& chromosomes, unsigned k = 0);
+
+	/**
+	 * Implicit path relinking in population k: walks from the best chromosome toward an elite one
+	 * drawn at random, copying the guide's genes one block of 'blockSize' alleles at a time in a
+	 * random block order. 'steps' evenly spaced points of the walk are decoded in parallel and the
+	 * best one replaces the worst chromosome if it is better.
+	 * @param blockSize alleles per block (e.g., the genes describing one item); smaller than n, so
+	 *        the walk has at least two blocks and a point strictly between its ends
+	 * @param steps intermediate chromosomes to decode (at most one per block boundary)
+	 * @return fitness of the best intermediate chromosome
+	 */
+	double pathRelink(unsigned blockSize, unsigned steps, unsigned k = 0);
+
+	/**
+	 * Configures how islands exchange elite chromosomes
+	 * @param topology which islands send to which, used by exchangeElite() as well
+	 * @param interval evolve() migrates every 'interval' generations (0 ==> only on exchangeElite)
+	 * @param M number of elite chromosomes each source island sends
+	 */
+	void setMigration(MigrationTopology topology, unsigned interval = 0, unsigned M = 1);
+
+	/**
+	 * Refines the k best chromosomes of every generation with Decoder::intensify() after sorting
+	 * (each chromosome once: elites copied forward keep their refined fitness). Chromosomes that
+	 * reach the top-k by other means (injection, migration, path relinking, resizing) are refined
+	 * too, and so are the current populations when this is called.
+	 * @param k number of top chromosomes to refine (0 ==> disabled)
+	 */
+	void setIntensification(unsigned k);
+
+	/**
+	 * Ranks each generation with nth_element plus a sort of the elite block instead of a full sort
+	 * (non-elite parents are drawn uniformly, so their order does not matter); getPopulationFitness
+	 * still reports every rank in order
+	 */
+	void setPartialRanking(bool partial);
+
+	/**
+	 * Before decoding, offspring whose Decoder::signature() matches an elite or an earlier
+	 * offspring of the same generation are replaced by fresh mutants, so no decode is spent on a
+	 * solution already in the population
+	 */
+	void setDuplicateElimination(bool eliminate);
+
+	/**
+	 * Publishes every chromosome decoded from now on (and, right away, the current populations)
+	 * into 'archive', from the decoding threads themselves; the archive may be shared with other
+	 * BRKGA objects and read concurrently (see EliteArchive). It is not part of checkpoints.
+	 * @param archive archive of n-allele chromosomes, or nullptr to stop publishing
+	 */
+	void setArchive(EliteArchive* archive);
+
+	/**
+	 * Lets evolve() resize every population each 'window' generations, within [minP, maxP]:
+	 * by 25% up when the best fitness improved by less than 0.1% in each of the last three windows
+	 * or the diversity (mean per-allele standard deviation, relative to that of random keys) fell
+	 * below 0.15, by 20% down when it improved by 0.1% or more and the diversity is above 0.35.
+	 * The size is then rounded so the p - pe chromosomes decoded per generation are a multiple of
+	 * 'granularity', e.g. a divisor of the usual core counts: a fixed value, rather than
+	 * MAX_THREADS, keeps the populations identical for any number of threads. pe and pm keep their
+	 * share of p; growing adds random chromosomes (decoded at once), shrinking drops the worst ones.
+	 * @param minP smallest population size (0 ==> fixed size)
+	 * @param maxP largest population size
+	 * @param window generations between two size decisions
+	 * @param granularity p - pe is rounded to a multiple of it (1 ==> no rounding)
+	 */
+	void setAdaptiveSize(unsigned minP, unsigned maxP, unsigned window = 10, unsigned granularity = 1);
+
+	/**
+	 * Adapts rhoe and the mutant share of p after every generation of evolve(), from statistics of
+	 * the new populations. rhoe rises while more than one generation in five (moving average)
+	 * improves the mean elite fitness, to exploit the elite, and falls otherwise; the mutant share
+	 * rises while the diversity (as in setAdaptiveSize) is below 0.3 and falls above it. Every
+	 * generation is logged (getParameterLog). evolve() then synchronizes the islands after each
+	 * generation. Multi-parent crossover does not use rhoe, so only pm moves then.
+	 * @param enable false ==> rhoe and pm stay where they are
+	 * @param rhoeMin, rhoeMax bounds of rhoe
+	 * @param pmMin, pmMax bounds of the mutant share of p
+	 */
+	void setParameterControl(bool enable, double rhoeMin = 0.55, double rhoeMax = 0.85, double pmMin = 0.02,
+			double pmMax = 0.25);
+
+	/**
+	 * Restarts a population after 'stagnation' generations of evolve() without improving its best
+	 * fitness: the best chromosome is kept, the other elites are kept with each allele redrawn
+	 * with probability 'perturbation' (0 ==> kept as they are), and the non-elite are drawn anew
+	 * @param stagnation generations without improvement that trigger a restart (0 ==> disabled)
+	 * @param perturbation probability of redrawing each allele of the elites but the best
+	 */
+	void setRestart(unsigned stagnation, double perturbation = 0.0);
+
+	/**
+	 * Mates each offspring from 'totalParents' distinct parents, 'eliteParents' of them elite and
+	 * the rest non-elite: parents are ranked by fitness and every allele is inherited from the
+	 * parent of rank r with probability bias(r) / sum of bias. evolve() only; rhoe is then unused
+	 * @param totalParents parents per offspring (0 ==> classic crossover with rhoe)
+	 * @param eliteParents how many of them are drawn from the elite set
+	 * @param bias weight of each parent rank
+	 */
+	void setMultiParent(unsigned totalParents, unsigned eliteParents, BiasFunction bias = BiasFunction::LOGINVERSE);
+
 	/**
 	 * Returns the current population
 	 */
 	const Population& getPopulation(unsigned k = 0) const;
 
 	/**
-	 * Returns the chromosome with best fitness so far among all populations
+	 * Returns (a copy of) the chromosome with best fitness so far among all populations
 	 */
-	const std::vector< double >& getBestChromosome() const;
+	std::vector< double > getBestChromosome() const;
 
 	double getPopulationFitness(unsigned k, unsigned i) const {
-        return current[k]->fitness[i].first;
+        return current[k]->getFitness(i);
     }
 
 	/**
@@ -116,6 +320,56 @@ public:
 	 */
 	double getBestFitness() const;
 
+	/**
+	 * Per-thread seconds spent decoding (busy) and waiting for the rest of the team at the end of
+	 * the decode loops (idle) of population k, accumulated since construction
+	 */
+	const std::vector< double >& getBusyTime(unsigned k = 0) const;
+	const std::vector< double >& getIdleTime(unsigned k = 0) const;
+
+	/**
+	 * Duplicates replaced before decoding in the last generation of population k (i.e., decodes
+	 * of an already known solution that were saved), and in total since construction
+	 */
+	unsigned getDuplicates(unsigned k = 0) const;
+	unsigned long long getTotalDuplicates(unsigned k = 0) const;
+
+	/**
+	 * Writes every population (both buffers, with their fitness, ranking and refined flags), the
+	 * generation and evaluation counters, the RNG state and the stagnation/duplicate bookkeeping
+	 * to a binary file.
+	 * The file is written under a temporary name and renamed, so a crash never leaves it truncated.
+	 * loadCheckpoint() restores it into a BRKGA built with the same n, p, pe, pm, rhoe and K (the
+	 * other settings are not saved); evolution then resumes exactly as if never interrupted.
+	 * Both throw std::runtime_error on I/O errors or mismatching parameters; a failed load leaves
+	 * the BRKGA unchanged.
+	 * @param caller values of the caller's own to save along (e.g. the wall time of the run so far),
+	 *        given back by loadCheckpoint() if not null
+	 */
+	void saveCheckpoint(const std::string& path,
+			const std::vector< double >& caller = std::vector< double >()) const;
+	void loadCheckpoint(const std::string& path, std::vector< double >* caller = nullptr);
+
+	/**
+	 * Generations evolved so far (evolve() and evolveSteadyState() calls count one each)
+	 */
+	unsigned getGeneration() const;
+
+	/**
+	 * Restarts performed on population k, in order
+	 */
+	const std::vector< RestartEvent >& getRestarts(unsigned k = 0) const;
+
+	/**
+	 * Population size changes made so far by setAdaptiveSize, in order
+	 */
+	const std::vector< ResizeEvent >& getResizes() const;
+
+	/**
+	 * One entry per generation evolved under setParameterControl, in order
+	 */
+	const std::vector< GenerationStats >& getParameterLog() const;
+
 	// Return copies to the internal parameters:
 	unsigned getN() const;
 	unsigned getP() const;
@@ -129,10 +383,14 @@ public:
 private:
 	// Hyperparameters:
 	const unsigned n;	// number of genes in the chromosome
-	const unsigned p;	// number of elements in the population
-	const unsigned pe;	// number of elite items in the population
-	const unsigned pm;	// number of mutants introduced at each generation into the population
-	const double rhoe;	// probability that an offspring inherits the allele of its elite parent
+	unsigned p;			// number of elements in the population (see setAdaptiveSize)
+	unsigned pe;		// number of elite items in the population
+	unsigned pm;		// number of mutants introduced at each generation into the population
+	double rhoe;		// probability that an offspring inherits the allele of its elite parent
+	const double eliteShare;	// pe / p, kept when p changes
+	double mutantShare;			// pm / p, kept when p changes (see setParameterControl)
+	const unsigned initialP, initialPe, initialPm;	// as constructed (checked by loadCheckpoint)
+	const double initialRhoe;
 
 	// Templates:
 	RNG& refRNG;				// reference to the random number generator
@@ -141,23 +399,113 @@ private:
 	// Parallel populations parameters:
 	const unsigned K;				// number of independent parallel populations
 	const unsigned MAX_THREADS;		// number of threads for parallel decoding
+	const unsigned islandThreads;	// threads of each island while islands evolve concurrently
+
+	// Migration:
+	MigrationTopology topology;		// islands exchanging elite chromosomes
+	unsigned migrationInterval;		// generations between automatic migrations (0 ==> off)
+	unsigned migrationSize;			// elite chromosomes sent by each source island
+
+	// Intensification:
+	unsigned intensifyK;			// number of top chromosomes refined after sorting (0 ==> off)
+	bool partialRanking;			// order only the elite (and intensified) block of each generation
+	bool eliminateDuplicates;		// re-mutate offspring that decode to a known solution
+	EliteArchive* archive;			// receives every decoded chromosome (nullptr ==> none)
+
+	// Restarts:
+	unsigned restartAfter;			// generations without improvement before a restart (0 ==> off)
+	double restartPerturbation;		// probability of redrawing an allele of a kept elite
+
+	// Adaptive population size:
+	unsigned minP, maxP;			// bounds of p (minP == 0 ==> fixed size)
+	unsigned sizeWindow;			// generations between size decisions
+	unsigned sizeGranularity;		// p - pe is kept a multiple of it
+	double windowBest;				// best fitness when the current window began
+	unsigned stalledWindows;		// consecutive windows improving it by less than 0.1%
+	static const unsigned STALLED_WINDOWS = 3;	// ... before p grows
+	std::vector< ResizeEvent > resizes;
+
+	// Online control of rhoe and pm:
+	bool parameterControl;
+	double rhoeMin, rhoeMax;		// bounds of rhoe
+	double pmMin, pmMax;			// bounds of mutantShare
+	double eliteMean;				// mean elite fitness after the last generation
+	double success;					// moving average of generations improving 'eliteMean'
+	std::vector< GenerationStats > parameterLog;
+
+	// Multi-parent crossover:
+	unsigned totalParents;			// parents per offspring (0 ==> classic two-parent crossover)
+	unsigned eliteParents;			// elite parents among them
+	std::vector< double > cumulativeBias;	// cumulative inheritance probability by parent rank
+
+	// Counter-based offspring generation:
+	uint64_t seed;					// key of the Philox streams, drawn from refRNG (or checkpoint)
+	uint32_t generation;			// generations evolved so far, the Philox stream id
 
 	// Data:
 	std::vector< Population* > previous;	// previous populations
 	std::vector< Population* > current;		// current populations
 
+	// Decode load balance, per population and thread:
+	std::vector< std::vector< double > > busyTime;
+	std::vector< std::vector< double > > idleTime;
+
+	// Duplicate elimination, per population:
+	std::vector< unsigned > duplicates;					// in the last generation
+	std::vector< unsigned long long > totalDuplicates;	// since construction
+
+	// Stagnation, per population:
+	std::vector< double > bestSeen;			// best fitness since the last restart
+	std::vector< unsigned > stagnant;		// generations without improving 'bestSeen'
+	std::vector< std::vector< RestartEvent > > restarts;
+
 	// Local operations:
 	void initialize(const unsigned i);		// initialize current population 'i' with random keys
-	void evolution(Population& curr, Population& next);
-	bool isRepeated(const std::vector< double >& chrA, const std::vector< double >& chrB) const;
+	void evolution(Population& curr, Population& next, unsigned k, uint32_t gen);
+	void intensify(Population& pop);				// refine the top-k rows not refined yet
+	double decode(Population& pop, unsigned i) const;	// Decoder::decode on chromosome i
+	void decodeAll(Population& pop, unsigned k, unsigned first, unsigned last);	// [first, last)
+	double refine(Population& pop, unsigned i) const;	// Decoder::intensify on chromosome i
+	void rankPopulation(Population& pop) const;			// full or partial sort, see setPartialRanking
+	void removeDuplicates(Population& pop, unsigned k, uint32_t gen);	// re-mutate repeated offspring
+	void checkStagnation(unsigned k, uint32_t gen);	// restarts population k if it stagnated
+	void restart(unsigned k, uint32_t gen);			// partial restart of population k
+	void adaptSize();								// setAdaptiveSize decision
+	void adaptParameters();							// setParameterControl update
+	double meanElite() const;						// mean elite fitness over the populations
+	void resize(unsigned size);						// every population to 'size' chromosomes
+	void setSize(unsigned size);					// p, and pe and pm in proportion
+	unsigned roundSize(unsigned size) const;		// nearest size in [minP, maxP] fitting the granularity
+	bool fitsSize(unsigned size) const;				// whether every setting is valid with p = size
+	double diversity(const Population& pop) const;
+	void mateMultiParent(const Population& curr, Philox& rng, double* offspring) const;
+	unsigned threads() const;	// MAX_THREADS, or the island's slice inside the island region
+	std::vector< unsigned > migrationSources(unsigned i);	// islands sending to island i
+	void placeMigrant(Population& pop, unsigned dest, const double* chromosome, double fitness,
+			bool refined);	// at rank dest
+	void publish(double fitness, const std::vector< double >& chromosome) const;	// to 'archive'
+	bool isRepeated(std::unordered_set< unsigned long long >& seen, unsigned long long signature) const;
+
+	static uint64_t drawSeed(RNG& rng) {
+		const uint64_t high = rng.randInt();
+		return (high << 32) | (rng.randInt() & 0xFFFFFFFFul);
+	}
 };
 
 template< class Decoder, class RNG >
 BRKGA< Decoder, RNG >::BRKGA(unsigned _n, unsigned _p, double _pe, double _pm, double _rhoe,
 		const Decoder& decoder, RNG& rng, unsigned _K, unsigned MAX) : n(_n), p(_p),
-		pe(unsigned(_pe * p)), pm(unsigned(_pm * p)), rhoe(_rhoe),
+		pe(unsigned(_pe * p)), pm(unsigned(_pm * p)), rhoe(_rhoe), eliteShare(_pe), mutantShare(_pm),
+		initialP(p), initialPe(pe), initialPm(pm), initialRhoe(_rhoe),
 		refRNG(rng), refDecoder(decoder), K(_K), MAX_THREADS(MAX),
-		previous(K, 0), current(K, 0) {
+		islandThreads(std::max(1u, MAX / std::max(1u, _K))), topology(MigrationTopology::ALL_TO_ALL),
+		migrationInterval(0), migrationSize(1), intensifyK(0), partialRanking(false),
+		eliminateDuplicates(false), archive(nullptr), restartAfter(0), restartPerturbation(0.0),
+		minP(0), maxP(0), sizeWindow(0), sizeGranularity(1), windowBest(0.0), stalledWindows(0),
+		parameterControl(false), rhoeMin(0.0), rhoeMax(1.0), pmMin(0.0), pmMax(1.0), eliteMean(0.0), success(0.0),
+		totalParents(0), eliteParents(0), seed(drawSeed(rng)), generation(0),
+		previous(K, 0), current(K, 0), busyTime(K), idleTime(K),
+		duplicates(K, 0), totalDuplicates(K, 0), bestSeen(K), stagnant(K, 0), restarts(K) {
 
 	// Error check:
 	using std::range_error;
@@ -169,6 +517,9 @@ BRKGA< Decoder, RNG >::BRKGA(unsigned _n, unsigned _p, double _pe, double _pm, d
 	if(pe + pm > p) { throw range_error("elite + mutant sets greater than population size (p)."); }
 	if(K == 0) { throw range_error("Number of parallel populations cannot be zero."); }
 
+	// Islands run in an outer parallel region and decode in an inner one:
+	if(K > 1 && MAX_THREADS > 1 && omp_get_max_active_levels() < 2) { omp_set_max_active_levels(2); }
+
 	// Initialize and decode each chromosome of the current population, then copy to previous:
 	for(unsigned i = 0; i < K; ++i) {
 		// Allocate:
@@ -203,57 +554,815 @@ double BRKGA< Decoder, RNG >::getBestFitness() const {
 }
 
 template< class Decoder, class RNG >
-const std::vector< double >& BRKGA< Decoder, RNG >::getBestChromosome() const {
+std::vector< double > BRKGA< Decoder, RNG >::getBestChromosome() const {
 	unsigned bestK = 0;
 	for(unsigned i = 1; i < K; ++i) {
 		if( current[i]->getBestFitness() < current[bestK]->getBestFitness() ) { bestK = i; }
 	}
 
-	return current[bestK]->getChromosome(0);	// The top one :-)
+	const double* best = current[bestK]->getChromosome(0);	// The top one :-)
+	return std::vector< double >(best, best + n);
 }
 
 template< class Decoder, class RNG >
 void BRKGA< Decoder, RNG >::reset() {
-	for(unsigned i = 0; i < K; ++i) { initialize(i); }
+	for(unsigned i = 0; i < K; ++i) {
+		initialize(i);
+		bestSeen[i] = current[i]->fitness[0].first;
+		stagnant[i] = 0;
+	}
 }
 
 template< class Decoder, class RNG >
 void BRKGA< Decoder, RNG >::evolve(unsigned generations) {
 	if(generations == 0) { throw std::range_error("Cannot evolve for 0 generations."); }
 
-	for(unsigned i = 0; i < generations; ++i) {
-		for(unsigned j = 0; j < K; ++j) {
-			evolution(*current[j], *previous[j]);	// First evolve the population (curr, next)
-			std::swap(current[j], previous[j]);		// Update (prev = curr; curr = prev == next)
+	unsigned done = 0;
+	while(done < generations) {
+		// Islands are independent until the next migration (or the end of this call):
+		unsigned span = generations - done;
+		if(migrationInterval > 0) { span = std::min(span, migrationInterval - generation % migrationInterval); }
+		if(minP > 0) { span = std::min(span, sizeWindow - generation % sizeWindow); }
+		if(parameterControl) { span = 1; }
+
+		#ifdef _OPENMP
+			#pragma omp parallel for num_threads(std::min(K, MAX_THREADS)) schedule(static, 1) if(K > 1)
+		#endif
+		for(int j = 0; j < int(K); ++j) {
+			for(unsigned g = 0; g < span; ++g) {
+				evolution(*current[j], *previous[j], j, generation + g);	// First evolve (curr, next)
+				std::swap(current[j], previous[j]);		// Update (prev = curr; curr = prev == next)
+				if(restartAfter > 0) { checkStagnation(j, generation + g); }
+			}
+		}
+
+		generation += span;
+		done += span;
+
+		if(migrationInterval > 0 && K > 1 && generation % migrationInterval == 0) {
+			exchangeElite(migrationSize);
+		}
+
+		if(minP > 0 && generation % sizeWindow == 0) { adaptSize(); }
+		if(parameterControl) { adaptParameters(); }
+	}
+}
+
+template< class Decoder, class RNG >
+void BRKGA< Decoder, RNG >::evolveSteadyState(unsigned offspring, unsigned k) {
+	if(offspring == 0) { throw std::range_error("Cannot evolve for 0 offspring."); }
+
+	Population& pop = *current[k];
+	pop.sortFitness();	// insertion below keeps every rank in place
+
+	std::mutex ranking;					// guards the rows and 'fitness' of 'pop'
+	std::atomic< unsigned > ticket(0);	// next offspring to produce
+	const uint64_t islandSeed = seed + k * 0x9E3779B97F4A7C15ull;
+
+	#ifdef _OPENMP
+		#pragma omp parallel num_threads(threads())
+	#endif
+	{
+		std::vector< double > chromosome(n), uniforms(n);
+
+		for(unsigned t = ticket++; t < offspring; t = ticket++) {
+			// Streams with the high bit set never collide with the (generation, individual) ones:
+			Philox rng(islandSeed, generation, (1u << 31) | t);
+
+			if(rng.rand() * p < pm) {
+				rng.fill(chromosome.data(), n);
+			} else {
+				const unsigned eliteParent = rng.randInt(pe - 1);
+				const unsigned noneliteParent = pe + rng.randInt(p - pe - 1);
+				rng.fill(uniforms.data(), n);
+
+				std::lock_guard< std::mutex > lock(ranking);
+				const double* elite = pop(pop.fitness[eliteParent].second);
+				const double* nonelite = pop(pop.fitness[noneliteParent].second);
+				for(unsigned j = 0; j < n; ++j) {
+					chromosome[j] = (uniforms[j] < rhoe) ? elite[j] : nonelite[j];
+				}
+			}
+
+			#pragma omp atomic
+			++evaluations;
+			const double f = refDecoder.decode(chromosome);
+			publish(f, chromosome);
+
+			// Replace the worst chromosome and bubble its entry up to its rank:
+			std::lock_guard< std::mutex > lock(ranking);
+			if(f >= pop.fitness[p - 1].first) { continue; }
+
+			std::pair< double, unsigned > entry(f, pop.fitness[p - 1].second);
+			std::memcpy(pop(entry.second), chromosome.data(), n * sizeof(double));
+			pop.refined[entry.second] = 0;
+
+			unsigned r = p - 1;
+			for(; r > 0 && entry < pop.fitness[r - 1]; --r) { pop.fitness[r] = pop.fitness[r - 1]; }
+			pop.fitness[r] = entry;
+			pop.sortedValid = false;
 		}
 	}
+
+	++generation;	// fresh streams for the next call
+}
+
+template< class Decoder, class RNG >
+void BRKGA< Decoder, RNG >::setMigration(MigrationTopology _topology, unsigned interval, unsigned M) {
+	if(M == 0 || M >= p) { throw std::range_error("M cannot be zero or >= p."); }
+	topology = _topology;
+	migrationInterval = interval;
+	migrationSize = M;
+}
+
+template< class Decoder, class RNG >
+std::vector< unsigned > BRKGA< Decoder, RNG >::migrationSources(const unsigned i) {
+	std::vector< unsigned > sources;
+	if(K < 2) { return sources; }
+
+	switch(topology) {
+	case MigrationTopology::ALL_TO_ALL:
+		for(unsigned j = 0; j < K; ++j) { if(j != i) { sources.push_back(j); } }
+		break;
+
+	case MigrationTopology::RING:
+		sources.push_back((i + K - 1) % K);
+		break;
+
+	case MigrationTopology::TORUS: {
+		// The most square rows x cols grid holding the K islands:
+		unsigned rows = 1;
+		for(unsigned r = 1; r * r <= K; ++r) { if(K % r == 0) { rows = r; } }
+		const unsigned cols = K / rows, row = i / cols, col = i % cols;
+
+		const unsigned neighbors[4] = {
+			((row + rows - 1) % rows) * cols + col, ((row + 1) % rows) * cols + col,
+			row * cols + (col + cols - 1) % cols, row * cols + (col + 1) % cols };
+		for(unsigned j : neighbors) {
+			if(j != i && std::find(sources.begin(), sources.end(), j) == sources.end()) {
+				sources.push_back(j);
+			}
+		}
+		break;
+	}
+
+	case MigrationTopology::RANDOM: {
+		const unsigned j = refRNG.randInt(K - 2);	// any island but i
+		sources.push_back(j < i ? j : j + 1);
+		break;
+	}
+	}
+
+	return sources;
 }
 
 template< class Decoder, class RNG >
 void BRKGA< Decoder, RNG >::exchangeElite(unsigned M) {
 	if(M == 0 || M >= p) { throw std::range_error("M cannot be zero or >= p."); }
 
+	// Migrants replace the worst chromosomes, so every rank must be in place:
+	for(unsigned i = 0; i < K; ++i) { current[i]->sortFitness(); }
+
 	for(unsigned i = 0; i < K; ++i) {
+		const std::vector< unsigned > sources = migrationSources(i);
+		if(sources.size() * M > p - pe) { throw std::range_error("Migrants would replace elite chromosomes."); }
+
 		// Population i will receive some elite members from each Population j below:
 		unsigned dest = p - 1;	// Last chromosome of i (will be updated below)
-		for(unsigned j = 0; j < K; ++j) {
-			if(j == i) { continue; }
-
+		for(unsigned j : sources) {
 			// Copy the M best of Population j into Population i:
 			for(unsigned m = 0; m < M; ++m) {
 				// Copy the m-th best of Population j into the 'dest'-th position of Population i:
-				const std::vector< double >& bestOfJ = current[j]->getChromosome(m);
+				const Population& source = *current[j];
+				placeMigrant(*current[i], dest--, source.getChromosome(m), source.fitness[m].first,
+						source.refined[source.fitness[m].second]);
+			}
+		}
+	}
+
+	for(int j = 0; j < int(K); ++j) {
+		current[j]->sortFitness();
+		if(intensifyK > 0) { intensify(*current[j]); }
+	}
+}
+
+template< class Decoder, class RNG >
+void BRKGA< Decoder, RNG >::importElite(const std::vector< std::pair< double, std::vector< double > > >& migrants,
+		unsigned k) {
+	if(migrants.size() > p - pe) { throw std::range_error("Migrants would replace elite chromosomes."); }
+
+	Population& pop = *current[k];
+	pop.sortFitness();
+
+	unsigned dest = p - 1;
+	for(const std::pair< double, std::vector< double > >& migrant : migrants) {
+		if(migrant.second.size() != n) { throw std::range_error("Migrants must have n alleles."); }
+		placeMigrant(pop, dest--, migrant.second.data(), migrant.first, false);
+	}
+
+	pop.sortFitness();
+	if(intensifyK > 0) { intensify(pop); }
+}
+
+template< class Decoder, class RNG >
+inline void BRKGA< Decoder, RNG >::placeMigrant(Population& pop, const unsigned dest, const double* chromosome,
+		const double fitness, const bool refined) {
+	std::memcpy(pop.getChromosome(dest), chromosome, n * sizeof(double));
+	pop.fitness[dest].first = fitness;
+	pop.refined[pop.fitness[dest].second] = refined;
+}
+
+template< class Decoder, class RNG >
+void BRKGA< Decoder, RNG >::injectChromosomes(const std::vector< std::vector< double > >& chromosomes,
+		unsigned k) {
+	const unsigned count = chromosomes.size();
+	if(count == 0) { return; }
+	if(count > p) { throw std::range_error("Cannot inject more than p chromosomes."); }
+	for(const std::vector< double >& chromosome : chromosomes) {
+		if(chromosome.size() != n) { throw std::range_error("Injected chromosomes must have n alleles."); }
+	}
+
+	// Decode apart first, so the batch is scheduled like any other:
+	Population injected(n, count);
+	const double top = std::nextafter(1.0, 0.0);
+	for(unsigned i = 0; i < count; ++i) {
+		for(unsigned j = 0; j < n; ++j) { injected(i, j) = std::min(std::max(chromosomes[i][j], 0.0), top); }
+	}
+	decodeAll(injected, k, 0, count);
+
+	Population& pop = *current[k];
+	pop.sortFitness();
+	for(unsigned i = 0; i < count; ++i) {
+		std::pair< double, unsigned >& worst = pop.fitness[p - 1 - i];
+		std::memcpy(pop(worst.second), injected(i), n * sizeof(double));
+		worst.first = injected.fitness[i].first;
+		pop.refined[worst.second] = 0;
+	}
+	pop.sortFitness();
+	if(intensifyK > 0) { intensify(pop); }
+}
+
+template< class Decoder, class RNG >
+double BRKGA< Decoder, RNG >::pathRelink(unsigned blockSize, unsigned steps, unsigned k) {
+	if(blockSize == 0 || blockSize >= n) { throw std::range_error("Block size must be in [1, n)."); }
+	if(steps == 0) { throw std::range_error("Path relinking needs at least one step."); }
+	if(pe < 2) { throw std::range_error("Path relinking needs at least two elite chromosomes."); }
 
-				std::copy(bestOfJ.begin(), bestOfJ.end(), current[i]->getChromosome(dest).begin());
+	Population& pop = *current[k];
+	pop.sortFitness();	// the best intermediate replaces the worst chromosome
 
-				current[i]->fitness[dest].first = current[j]->fitness[m].first;
+	const double* base = pop.getChromosome(0);
+	const double* guide = pop.getChromosome(1 + refRNG.randInt(pe - 2));
 
-				--dest;
+	// Random order in which the guide's blocks are copied over the base:
+	const unsigned blocks = (n + blockSize - 1) / blockSize;
+	std::vector< unsigned > order(blocks);
+	for(unsigned b = 0; b < blocks; ++b) { order[b] = b; }
+	for(unsigned b = blocks - 1; b > 0; --b) { std::swap(order[b], order[refRNG.randInt(b)]); }
+
+	// Point t of the walk holds the guide's first (t + 1) * blocks / (steps + 1) blocks:
+	steps = std::min(steps, blocks - 1);	// the guide itself is never an intermediate
+	Population path(n, steps);
+	#ifdef _OPENMP
+		#pragma omp parallel for num_threads(threads())
+	#endif
+	for(int t = 0; t < int(steps); ++t) {
+		double* chromosome = path(t);
+		std::memcpy(chromosome, base, n * sizeof(double));
+
+		const unsigned copied = std::max(1u, unsigned((t + 1ull) * blocks / (steps + 1)));
+		for(unsigned b = 0; b < copied; ++b) {
+			const unsigned first = order[b] * blockSize, last = std::min(n, first + blockSize);
+			std::memcpy(chromosome + first, guide + first, (last - first) * sizeof(double));
+		}
+	}
+
+	decodeAll(path, k, 0, steps);
+	path.sortFitness();
+
+	const std::pair< double, unsigned > best = path.fitness[0];
+	if(best.first < pop.fitness[p - 1].first) {
+		std::memcpy(pop(pop.fitness[p - 1].second), path(best.second), n * sizeof(double));
+		pop.fitness[p - 1].first = best.first;
+		pop.refined[pop.fitness[p - 1].second] = 0;
+		pop.sortFitness();
+		if(intensifyK > 0) { intensify(pop); }
+	}
+
+	return best.first;
+}
+
+// Raw binary I/O of checkpoints (native byte order: meant to resume on the same kind of machine)
+namespace checkpoint {
+
+const char MAGIC[8] = { 'B', 'R', 'K', 'G', 'A', 'C', 'K', '5' };
+
+template< class T >
+inline void writeValue(FILE* file, const T& value) {
+	if(std::fwrite(&value, sizeof(T), 1, file) != 1) { throw std::runtime_error("Cannot write checkpoint."); }
+}
+
+template< class T >
+inline void writeArray(FILE* file, const T* values, std::size_t count) {
+	if(std::fwrite(values, sizeof(T), count, file) != count) { throw std::runtime_error("Cannot write checkpoint."); }
+}
+
+template< class T >
+inline T readValue(FILE* file) {
+	T value;
+	if(std::fread(&value, sizeof(T), 1, file) != 1) { throw std::runtime_error("Truncated checkpoint."); }
+	return value;
+}
+
+template< class T >
+inline void readArray(FILE* file, T* values, std::size_t count) {
+	if(std::fread(values, sizeof(T), count, file) != count) { throw std::runtime_error("Truncated checkpoint."); }
+}
+
+}
+
+template< class Decoder, class RNG >
+void BRKGA< Decoder, RNG >::saveCheckpoint(const std::string& path, const std::vector< double >& caller) const {
+	const std::string temporary = path + ".tmp";
+	FILE* file = std::fopen(temporary.c_str(), "wb");
+	if(file == 0) { throw std::runtime_error("Cannot create checkpoint " + temporary + "."); }
+
+	try {
+		checkpoint::writeArray(file, checkpoint::MAGIC, sizeof(checkpoint::MAGIC));
+		checkpoint::writeValue< uint32_t >(file, n);
+		checkpoint::writeValue< uint32_t >(file, initialP);
+		checkpoint::writeValue< uint32_t >(file, initialPe);
+		checkpoint::writeValue< uint32_t >(file, initialPm);
+		checkpoint::writeValue< uint32_t >(file, K);
+		checkpoint::writeValue< double >(file, initialRhoe);
+		checkpoint::writeValue< uint64_t >(file, seed);
+		checkpoint::writeValue< uint32_t >(file, generation);
+		checkpoint::writeValue< int64_t >(file, evaluations);
+
+		std::vector< typename RNG::uint32 > rngState(RNG::SAVE);
+		refRNG.save(rngState.data());
+		for(unsigned w = 0; w < unsigned(RNG::SAVE); ++w) { checkpoint::writeValue< uint32_t >(file, uint32_t(rngState[w])); }
+
+		checkpoint::writeValue< uint32_t >(file, caller.size());
+		checkpoint::writeArray(file, caller.data(), caller.size());
+
+		checkpoint::writeValue< uint32_t >(file, p);
+		checkpoint::writeValue< double >(file, windowBest);
+		checkpoint::writeValue< uint32_t >(file, stalledWindows);
+		checkpoint::writeValue< uint32_t >(file, resizes.size());
+		for(const ResizeEvent& event : resizes) {
+			checkpoint::writeValue< uint32_t >(file, event.generation);
+			checkpoint::writeValue< uint32_t >(file, event.p);
+			checkpoint::writeValue< double >(file, event.diversity);
+			checkpoint::writeValue< double >(file, event.gain);
+		}
+
+		checkpoint::writeValue< double >(file, rhoe);
+		checkpoint::writeValue< double >(file, mutantShare);
+		checkpoint::writeValue< double >(file, eliteMean);
+		checkpoint::writeValue< double >(file, success);
+		checkpoint::writeValue< uint32_t >(file, parameterLog.size());
+		for(const GenerationStats& stats : parameterLog) {
+			checkpoint::writeValue< uint32_t >(file, stats.generation);
+			checkpoint::writeValue< uint32_t >(file, stats.p);
+			checkpoint::writeValue< double >(file, stats.rhoe);
+			checkpoint::writeValue< double >(file, stats.pm);
+			checkpoint::writeValue< double >(file, stats.diversity);
+			checkpoint::writeValue< double >(file, stats.success);
+		}
+
+		for(unsigned k = 0; k < K; ++k) {
+			checkpoint::writeValue< double >(file, bestSeen[k]);
+			checkpoint::writeValue< uint32_t >(file, stagnant[k]);
+			checkpoint::writeValue< uint32_t >(file, duplicates[k]);
+			checkpoint::writeValue< uint64_t >(file, totalDuplicates[k]);
+
+			checkpoint::writeValue< uint32_t >(file, restarts[k].size());
+			for(const RestartEvent& event : restarts[k]) {
+				checkpoint::writeValue< uint32_t >(file, event.generation);
+				checkpoint::writeValue< uint32_t >(file, event.population);
+				checkpoint::writeValue< double >(file, event.bestFitness);
+			}
+
+			for(const Population* pop : { current[k], previous[k] }) {
+				checkpoint::writeValue< uint32_t >(file, pop->ranked);
+				for(unsigned i = 0; i < p; ++i) {
+					checkpoint::writeValue< double >(file, pop->fitness[i].first);
+					checkpoint::writeValue< uint32_t >(file, pop->fitness[i].second);
+				}
+				for(unsigned i = 0; i < p; ++i) { checkpoint::writeArray(file, (*pop)(i), n); }
+				checkpoint::writeArray(file, pop->refined.data(), p);
 			}
 		}
+	} catch(...) {
+		std::fclose(file);
+		std::remove(temporary.c_str());
+		throw;
 	}
 
-	for(int j = 0; j < int(K); ++j) { current[j]->sortFitness(); }
+	if(std::fclose(file) != 0 || std::rename(temporary.c_str(), path.c_str()) != 0) {
+		throw std::runtime_error("Cannot write checkpoint " + path + ".");
+	}
+}
+
+template< class Decoder, class RNG >
+void BRKGA< Decoder, RNG >::loadCheckpoint(const std::string& path, std::vector< double >* caller) {
+	FILE* file = std::fopen(path.c_str(), "rb");
+	if(file == 0) { throw std::runtime_error("Cannot open checkpoint " + path + "."); }
+
+	// Everything is read into locals and assigned only after the last read, so a truncated or
+	// mismatching file leaves this object untouched:
+	std::vector< Population* > loaded;
+	loaded.reserve(2 * K);
+	try {
+		char magic[sizeof(checkpoint::MAGIC)];
+		checkpoint::readArray(file, magic, sizeof(magic));
+		if(std::memcmp(magic, checkpoint::MAGIC, sizeof(magic)) != 0) {
+			throw std::runtime_error(path + " is not a BRKGA checkpoint.");
+		}
+
+		const uint32_t savedN = checkpoint::readValue< uint32_t >(file), savedP = checkpoint::readValue< uint32_t >(file);
+		const uint32_t savedPe = checkpoint::readValue< uint32_t >(file), savedPm = checkpoint::readValue< uint32_t >(file);
+		const uint32_t savedK = checkpoint::readValue< uint32_t >(file);
+		const double savedRhoe = checkpoint::readValue< double >(file);
+		if(savedN != n || savedP != initialP || savedPe != initialPe || savedPm != initialPm || savedK != K ||
+				savedRhoe != initialRhoe) {
+			throw std::runtime_error("Checkpoint " + path + " was saved with different parameters.");
+		}
+
+		const uint64_t savedSeed = checkpoint::readValue< uint64_t >(file);
+		const uint32_t savedGeneration = checkpoint::readValue< uint32_t >(file);
+		const int64_t savedEvaluations = checkpoint::readValue< int64_t >(file);
+
+		std::vector< typename RNG::uint32 > rngState(RNG::SAVE);
+		for(unsigned w = 0; w < unsigned(RNG::SAVE); ++w) { rngState[w] = checkpoint::readValue< uint32_t >(file); }
+
+		std::vector< double > savedCaller(checkpoint::readValue< uint32_t >(file));
+		checkpoint::readArray(file, savedCaller.data(), savedCaller.size());
+
+		const uint32_t savedSize = checkpoint::readValue< uint32_t >(file);
+		if(savedSize == 0) { throw std::runtime_error("Checkpoint " + path + " has an empty population."); }
+		const double savedWindowBest = checkpoint::readValue< double >(file);
+		const uint32_t savedStalledWindows = checkpoint::readValue< uint32_t >(file);
+		std::vector< ResizeEvent > savedResizes(checkpoint::readValue< uint32_t >(file));
+		for(ResizeEvent& event : savedResizes) {
+			event.generation = checkpoint::readValue< uint32_t >(file);
+			event.p = checkpoint::readValue< uint32_t >(file);
+			event.diversity = checkpoint::readValue< double >(file);
+			event.gain = checkpoint::readValue< double >(file);
+		}
+
+		const double savedCurrentRhoe = checkpoint::readValue< double >(file);
+		const double savedMutantShare = checkpoint::readValue< double >(file);
+		const double savedEliteMean = checkpoint::readValue< double >(file);
+		const double savedSuccess = checkpoint::readValue< double >(file);
+		std::vector< GenerationStats > savedParameterLog(checkpoint::readValue< uint32_t >(file));
+		for(GenerationStats& stats : savedParameterLog) {
+			stats.generation = checkpoint::readValue< uint32_t >(file);
+			stats.p = checkpoint::readValue< uint32_t >(file);
+			stats.rhoe = checkpoint::readValue< double >(file);
+			stats.pm = checkpoint::readValue< double >(file);
+			stats.diversity = checkpoint::readValue< double >(file);
+			stats.success = checkpoint::readValue< double >(file);
+		}
+
+		std::vector< double > savedBestSeen(K);
+		std::vector< unsigned > savedStagnant(K), savedDuplicates(K);
+		std::vector< unsigned long long > savedTotalDuplicates(K);
+		std::vector< std::vector< RestartEvent > > savedRestarts(K);
+		for(unsigned k = 0; k < K; ++k) {
+			savedBestSeen[k] = checkpoint::readValue< double >(file);
+			savedStagnant[k] = checkpoint::readValue< uint32_t >(file);
+			savedDuplicates[k] = checkpoint::readValue< uint32_t >(file);
+			savedTotalDuplicates[k] = checkpoint::readValue< uint64_t >(file);
+
+			savedRestarts[k].resize(checkpoint::readValue< uint32_t >(file));
+			for(RestartEvent& event : savedRestarts[k]) {
+				event.generation = checkpoint::readValue< uint32_t >(file);
+				event.population = checkpoint::readValue< uint32_t >(file);
+				event.bestFitness = checkpoint::readValue< double >(file);
+			}
+
+			// Current, then previous population of island k
+			for(unsigned buffer = 0; buffer < 2; ++buffer) {
+				loaded.push_back(new Population(n, savedSize));
+				Population& pop = *loaded.back();
+				pop.ranked = checkpoint::readValue< uint32_t >(file);
+				for(unsigned i = 0; i < savedSize; ++i) {
+					pop.fitness[i].first = checkpoint::readValue< double >(file);
+					pop.fitness[i].second = checkpoint::readValue< uint32_t >(file);
+					if(pop.fitness[i].second >= savedSize) {
+						throw std::runtime_error("Checkpoint " + path + " is corrupted.");
+					}
+				}
+				if(pop.ranked > savedSize) { throw std::runtime_error("Checkpoint " + path + " is corrupted."); }
+				for(unsigned i = 0; i < savedSize; ++i) { checkpoint::readArray(file, pop(i), n); }
+				checkpoint::readArray(file, pop.refined.data(), savedSize);
+			}
+		}
+
+		seed = savedSeed;
+		generation = savedGeneration;
+		evaluations = savedEvaluations;
+		refRNG.load(rngState.data());
+		if(caller != nullptr) { caller->swap(savedCaller); }
+
+		windowBest = savedWindowBest;
+		stalledWindows = savedStalledWindows;
+		resizes.swap(savedResizes);
+
+		rhoe = savedCurrentRhoe;
+		mutantShare = savedMutantShare;
+		eliteMean = savedEliteMean;
+		success = savedSuccess;
+		parameterLog.swap(savedParameterLog);
+		setSize(savedSize);	// after the mutant share, which pm follows
+
+		bestSeen.swap(savedBestSeen);
+		stagnant.swap(savedStagnant);
+		duplicates.swap(savedDuplicates);
+		totalDuplicates.swap(savedTotalDuplicates);
+		restarts.swap(savedRestarts);
+		for(unsigned k = 0; k < K; ++k) {
+			std::swap(current[k], loaded[2 * k]);
+			std::swap(previous[k], loaded[2 * k + 1]);
+		}
+	} catch(...) {
+		for(Population* pop : loaded) { delete pop; }
+		std::fclose(file);
+		throw;
+	}
+
+	for(Population* pop : loaded) { delete pop; }	// the replaced populations
+	std::fclose(file);
+}
+
+template< class Decoder, class RNG >
+void BRKGA< Decoder, RNG >::setIntensification(unsigned k) {
+	if(k > p) { throw std::range_error("Intensification size greater than population size (k > p)."); }
+	intensifyK = k;
+
+	// The constructor ranked and decoded without it:
+	for(unsigned i = 0; i < K && k > 0; ++i) {
+		rankPopulation(*current[i]);
+		intensify(*current[i]);
+	}
+}
+
+template< class Decoder, class RNG >
+void BRKGA< Decoder, RNG >::setPartialRanking(bool partial) {
+	partialRanking = partial;
+}
+
+template< class Decoder, class RNG >
+void BRKGA< Decoder, RNG >::setDuplicateElimination(bool eliminate) {
+	eliminateDuplicates = eliminate;
+}
+
+template< class Decoder, class RNG >
+void BRKGA< Decoder, RNG >::setArchive(EliteArchive* _archive) {
+	if(_archive != nullptr && _archive->getN() != n) {
+		throw std::range_error("Archive chromosome size differs from n.");
+	}
+	archive = _archive;
+
+	std::vector< double > chromosome(n);
+	for(unsigned k = 0; archive != nullptr && k < K; ++k) {
+		const Population& pop = *current[k];
+		for(unsigned i = 0; i < p; ++i) {
+			const unsigned row = pop.fitness[i].second;
+			chromosome.assign(pop(row), pop(row) + n);
+			publish(pop.fitness[i].first, chromosome);
+		}
+	}
+}
+
+template< class Decoder, class RNG >
+void BRKGA< Decoder, RNG >::setMultiParent(unsigned total, unsigned elite, BiasFunction bias) {
+	if(total == 0) { totalParents = 0; eliteParents = 0; cumulativeBias.clear(); return; }
+	if(total < 2) { throw std::range_error("Multi-parent crossover needs at least 2 parents."); }
+	if(elite == 0 || elite > total) { throw std::range_error("Elite parents must be in [1, totalParents]."); }
+	if(elite > pe) { throw std::range_error("More elite parents than elite chromosomes."); }
+	if(total - elite > p - pe) { throw std::range_error("More non-elite parents than non-elite chromosomes."); }
+
+	cumulativeBias.assign(total, 0.0);
+	double sum = 0.0;
+	for(unsigned q = 0; q < total; ++q) {
+		const double r = q + 1;
+		double weight = 1.0;
+		switch(bias) {
+		case BiasFunction::CONSTANT:	weight = 1.0; break;
+		case BiasFunction::LINEAR:		weight = 1.0 / r; break;
+		case BiasFunction::QUADRATIC:	weight = 1.0 / (r * r); break;
+		case BiasFunction::CUBIC:		weight = 1.0 / (r * r * r); break;
+		case BiasFunction::EXPONENTIAL:	weight = std::exp(-r); break;
+		case BiasFunction::LOGINVERSE:	weight = 1.0 / std::log(r + 1.0); break;
+		}
+		sum += weight;
+		cumulativeBias[q] = sum;
+	}
+	for(unsigned q = 0; q < total; ++q) { cumulativeBias[q] /= sum; }
+
+	totalParents = total;
+	eliteParents = elite;
+}
+
+template< class Decoder, class RNG >
+void BRKGA< Decoder, RNG >::setRestart(unsigned stagnation, double perturbation) {
+	if(perturbation < 0.0 || perturbation > 1.0) { throw std::range_error("Perturbation must be in [0,1]."); }
+	restartAfter = stagnation;
+	restartPerturbation = perturbation;
+	for(unsigned i = 0; i < K; ++i) {
+		bestSeen[i] = current[i]->fitness[0].first;
+		stagnant[i] = 0;
+	}
+}
+
+template< class Decoder, class RNG >
+void BRKGA< Decoder, RNG >::setAdaptiveSize(unsigned _minP, unsigned _maxP, unsigned window,
+		unsigned granularity) {
+	if(_minP == 0) { minP = maxP = sizeWindow = 0; return; }
+	if(granularity == 0) { throw std::range_error("Population size granularity cannot be zero."); }
+	if(_minP > _maxP) { throw std::range_error("Minimum population size greater than maximum (minP > maxP)."); }
+	if(window == 0) { throw std::range_error("Population size window cannot be zero."); }
+	if(!fitsSize(_minP)) { throw std::range_error("Population size minP too small for the current settings."); }
+
+	minP = _minP;
+	maxP = _maxP;
+	sizeWindow = window;
+	sizeGranularity = granularity;
+
+	stalledWindows = 0;
+	windowBest = current[0]->fitness[0].first;
+	for(unsigned k = 1; k < K; ++k) { windowBest = std::min(windowBest, current[k]->fitness[0].first); }
+}
+
+template< class Decoder, class RNG >
+inline void BRKGA< Decoder, RNG >::adaptSize() {
+	double best = current[0]->fitness[0].first, spread = 0.0;
+	for(unsigned k = 0; k < K; ++k) {
+		best = std::min(best, current[k]->fitness[0].first);
+		spread += diversity(*current[k]) / K;
+	}
+
+	const double gain = (windowBest - best) / std::max(std::fabs(windowBest), 1e-12);
+	windowBest = best;
+
+	// Stalled or converged: more room to explore; improving with diversity to spare: faster generations
+	stalledWindows = (gain < 0.001) ? stalledWindows + 1 : 0;
+	unsigned size = p;
+	if(stalledWindows >= STALLED_WINDOWS || spread < 0.15) { size = p + (p + 3) / 4; stalledWindows = 0; }
+	else if(gain >= 0.001 && spread > 0.35) { size = p - p / 5; }
+
+	size = roundSize(size);
+	if(size == p) { return; }
+
+	resize(size);
+	const ResizeEvent event = { generation, p, spread, gain };
+	resizes.push_back(event);
+}
+
+template< class Decoder, class RNG >
+void BRKGA< Decoder, RNG >::setParameterControl(bool enable, double _rhoeMin, double _rhoeMax, double _pmMin,
+		double _pmMax) {
+	if(!enable) { parameterControl = false; return; }
+	if(_rhoeMin < 0.0 || _rhoeMin > _rhoeMax || _rhoeMax > 1.0) { throw std::range_error("rhoe bounds must be in [0,1]."); }
+	if(_pmMin < 0.0 || _pmMin > _pmMax) { throw std::range_error("Mutant share bounds must be ordered and >= 0."); }
+	if(eliteShare + _pmMax > 1.0) { throw std::range_error("elite + mutant sets greater than population size (p)."); }
+
+	parameterControl = true;
+	rhoeMin = _rhoeMin;
+	rhoeMax = _rhoeMax;
+	pmMin = _pmMin;
+	pmMax = _pmMax;
+
+	rhoe = std::min(std::max(rhoe, rhoeMin), rhoeMax);
+	mutantShare = std::min(std::max(mutantShare, pmMin), pmMax);
+	pm = unsigned(mutantShare * p);
+
+	eliteMean = meanElite();
+	success = 0.2;	// neutral: neither raises nor lowers rhoe
+}
+
+template< class Decoder, class RNG >
+inline void BRKGA< Decoder, RNG >::adaptParameters() {
+	double spread = 0.0;
+	for(unsigned k = 0; k < K; ++k) { spread += diversity(*current[k]) / K; }
+
+	const double elite = meanElite();
+	// Relative tolerance: a mean that only moved in its last bits (summation order, cached
+	// throughputs) is no success, so the adaptation does not hinge on rounding
+	const double tolerance = 1e-9 * std::max(std::fabs(elite), std::fabs(eliteMean));
+	success = 0.9 * success + 0.1 * (elite < eliteMean - tolerance ? 1.0 : 0.0);
+	eliteMean = elite;
+
+	// Proportional steps: toward exploitation while the elite improves, toward mutants when it
+	// converges
+	rhoe = std::min(std::max(rhoe + 0.05 * (success - 0.2), rhoeMin), rhoeMax);
+	mutantShare = std::min(std::max(mutantShare + 0.05 * (0.3 - spread), pmMin), pmMax);
+	pm = std::min(unsigned(mutantShare * p), p - pe);
+
+	const GenerationStats stats = { generation, p, rhoe, mutantShare, spread, success };
+	parameterLog.push_back(stats);
+}
+
+template< class Decoder, class RNG >
+inline double BRKGA< Decoder, RNG >::meanElite() const {
+	double sum = 0.0;
+	for(unsigned k = 0; k < K; ++k) {
+		for(unsigned i = 0; i < pe; ++i) { sum += current[k]->fitness[i].first; }
+	}
+	return sum / (double(K) * pe);
+}
+
+template< class Decoder, class RNG >
+inline void BRKGA< Decoder, RNG >::resize(const unsigned size) {
+	const unsigned oldP = p;
+	setSize(size);
+
+	for(unsigned k = 0; k < K; ++k) {
+		Population& curr = *current[k];
+		curr.sortFitness();	// shrinking keeps the best
+		curr.resize(p);
+		previous[k]->resize(p);
+		if(p <= oldP) { continue; }
+
+		// Newcomers draw from streams with bit 28 set, disjoint from every other use of Philox:
+		#ifdef _OPENMP
+			#pragma omp parallel for num_threads(threads())
+		#endif
+		for(int i = int(oldP); i < int(p); ++i) {
+			Philox rng(seed, generation, (1u << 28) | (k * p + i));
+			rng.fill(curr(i), n);
+		}
+
+		decodeAll(curr, k, oldP, p);
+		rankPopulation(curr);
+		if(intensifyK > 0) { intensify(curr); }
+	}
+}
+
+template< class Decoder, class RNG >
+inline void BRKGA< Decoder, RNG >::setSize(const unsigned size) {
+	p = size;
+	pe = std::max(1u, unsigned(eliteShare * size));
+	pm = std::min(unsigned(mutantShare * size), size - pe);
+}
+
+template< class Decoder, class RNG >
+inline unsigned BRKGA< Decoder, RNG >::roundSize(unsigned size) const {
+	size = std::min(std::max(size, minP), maxP);
+
+	// A fixed granularity, not the thread count, so the sizes do not depend on MAX_THREADS
+	const unsigned G = sizeGranularity;
+	const auto offspring = [this](unsigned q) { return q - std::max(1u, unsigned(eliteShare * q)); };
+	for(unsigned q = size; q <= maxP; ++q) {
+		if(offspring(q) > 0 && offspring(q) % G == 0 && fitsSize(q)) { return q; }
+	}
+	for(unsigned q = size; q > minP; --q) {
+		if(offspring(q - 1) > 0 && offspring(q - 1) % G == 0 && fitsSize(q - 1)) { return q - 1; }
+	}
+
+	return size;	// no size in range is a multiple of the granularity
+}
+
+template< class Decoder, class RNG >
+inline bool BRKGA< Decoder, RNG >::fitsSize(const unsigned size) const {
+	const unsigned e = std::max(1u, unsigned(eliteShare * size)), m = unsigned(mutantShare * size);
+	return e + m <= size && intensifyK <= size && migrationSize < size && eliteParents <= e &&
+			totalParents - eliteParents <= size - e;
+}
+
+template< class Decoder, class RNG >
+inline double BRKGA< Decoder, RNG >::diversity(const Population& pop) const {
+	// Standard deviation of each allele over the population, against sqrt(1/12) for uniform keys
+	std::vector< double > sum(n, 0.0), squares(n, 0.0);
+	for(unsigned i = 0; i < pop.p; ++i) {
+		const double* chromosome = pop(i);
+		for(unsigned j = 0; j < n; ++j) {
+			sum[j] += chromosome[j];
+			squares[j] += chromosome[j] * chromosome[j];
+		}
+	}
+
+	double spread = 0.0;
+	for(unsigned j = 0; j < n; ++j) {
+		const double mean = sum[j] / pop.p;
+		spread += std::sqrt(std::max(0.0, squares[j] / pop.p - mean * mean));
+	}
+
+	return spread / n * std::sqrt(12.0);
+}
+
+template< class Decoder, class RNG >
+inline unsigned BRKGA< Decoder, RNG >::threads() const {
+	return omp_in_parallel() ? islandThreads : MAX_THREADS;
+}
+
+template< class Decoder, class RNG >
+inline void BRKGA< Decoder, RNG >::rankPopulation(Population& pop) const {
+	if(partialRanking) { pop.rankFitness(std::max(pe, intensifyK)); }
+	else { pop.sortFitness(); }
 }
 
 template< class Decoder, class RNG >
@@ -263,74 +1372,333 @@ inline void BRKGA< Decoder, RNG >::initialize(const unsigned i) {
 	}
 
 	// Decode:
+	decodeAll(*current[i], i, 0, p);
+
+	// Sort:
+	rankPopulation(*current[i]);
+
+	if(intensifyK > 0) { intensify(*current[i]); }
+}
+
+template< class Decoder, class RNG >
+inline void BRKGA< Decoder, RNG >::evolution(Population& curr, Population& next, const unsigned k,
+		const uint32_t gen) {
+	// 2. The 'pe' best chromosomes are maintained, so we just copy these into 'current':
+	for(unsigned i = 0; i < pe; ++i) {
+		std::memcpy(next(i), curr(curr.fitness[i].second), n * sizeof(double));
+
+		next.fitness[i].first = curr.fitness[i].first;
+		next.fitness[i].second = i;
+		next.refined[i] = curr.refined[curr.fitness[i].second];
+	}
+
+	// 3. Every other chromosome draws from its own (seed, generation, individual) stream, so the
+	// 'p - pe - pm' offspring (i < p - pm) and the 'pm' mutants can be built in any order:
 	#ifdef _OPENMP
-		#pragma omp parallel for num_threads(MAX_THREADS)
+		#pragma omp parallel for num_threads(threads())
 	#endif
-	for(int j = 0; j < int(p); ++j) {
-        ++evaluations;
-		current[i]->setFitness(j, refDecoder.decode((*current[i])(j)) );
+	for(int i = int(pe); i < int(p); ++i) {
+		Philox rng(seed, gen, k * p + i);
+		double* offspring = next(i);
+
+		if(unsigned(i) < p - pm && totalParents > 0) {
+			mateMultiParent(curr, rng, offspring);
+		} else if(unsigned(i) < p - pm) {
+			// Select an elite parent:
+			const unsigned eliteParent = (rng.randInt(pe - 1));
+
+			// Select a non-elite parent:
+			const unsigned noneliteParent = pe + (rng.randInt(p - pe - 1));
+
+			// Mate: draw all n uniforms at once, then blend the parent rows branch-free
+			static thread_local std::vector< double > uniforms;
+			uniforms.resize(n);
+			rng.fill(uniforms.data(), n);
+
+			const double* elite = curr(curr.fitness[eliteParent].second);
+			const double* nonelite = curr(curr.fitness[noneliteParent].second);
+			const double* u = uniforms.data();
+			const double bias = rhoe;
+			#ifdef _OPENMP
+				#pragma omp simd
+			#endif
+			for(unsigned j = 0; j < n; ++j) {
+				const double e = elite[j], o = nonelite[j];	// load both rows: a select, not a branch
+				offspring[j] = (u[j] < bias) ? e : o;
+			}
+		} else {
+			// Mutant:
+			rng.fill(offspring, n);
+		}
 	}
 
-	// Sort:
-	current[i]->sortFitness();
+	if(eliminateDuplicates) { removeDuplicates(next, k, gen); }
+
+	// Time to compute fitness, in parallel:
+	decodeAll(next, k, pe, p);
+
+	// Now we must sort 'current' by fitness, since things might have changed:
+//	exit(44);
+	rankPopulation(next);
+
+	if(intensifyK > 0) { intensify(next); }
 }
 
 template< class Decoder, class RNG >
-inline void BRKGA< Decoder, RNG >::evolution(Population& curr, Population& next) {
-	// We now will set every chromosome of 'current', iterating with 'i':
-	unsigned i = 0;	// Iterate chromosome by chromosome
-	unsigned j = 0;	// Iterate allele by allele
+inline void BRKGA< Decoder, RNG >::mateMultiParent(const Population& curr, Philox& rng,
+		double* offspring) const {
+	// Distinct ranks, by rejection (parents are few compared to the sets they come from):
+	static thread_local std::vector< unsigned > ranks;
+	ranks.clear();
+	while(ranks.size() < eliteParents) {
+		const unsigned r = rng.randInt(pe - 1);
+		if(std::find(ranks.begin(), ranks.end(), r) == ranks.end()) { ranks.push_back(r); }
+	}
+	while(ranks.size() < totalParents) {
+		const unsigned r = pe + rng.randInt(p - pe - 1);
+		if(std::find(ranks.begin(), ranks.end(), r) == ranks.end()) { ranks.push_back(r); }
+	}
 
-	// 2. The 'pe' best chromosomes are maintained, so we just copy these into 'current':
-	while(i < pe) {
-		for(j = 0 ; j < n; ++j) { next(i,j) = curr(curr.fitness[i].second, j); }
+	// Elites come first, but non-elite ranks are only ordered by fitness, not by position:
+	std::sort(ranks.begin(), ranks.end(), [&curr](unsigned a, unsigned b) {
+		return curr.fitness[a] < curr.fitness[b];
+	});
+
+	static thread_local std::vector< const double* > parents;
+	parents.resize(totalParents);
+	for(unsigned q = 0; q < totalParents; ++q) { parents[q] = curr(curr.fitness[ranks[q]].second); }
+
+	static thread_local std::vector< double > uniforms;
+	uniforms.resize(n);
+	rng.fill(uniforms.data(), n);
+
+	for(unsigned j = 0; j < n; ++j) {
+		unsigned q = 0;
+		while(q + 1 < totalParents && uniforms[j] >= cumulativeBias[q]) { ++q; }
+		offspring[j] = parents[q][j];
+	}
+}
+
+template< class Decoder, class RNG >
+inline void BRKGA< Decoder, RNG >::removeDuplicates(Population& pop, const unsigned k, const uint32_t gen) {
+	std::vector< unsigned long long > signatures(p);
+	#ifdef _OPENMP
+		#pragma omp parallel for num_threads(threads())
+	#endif
+	for(int i = 0; i < int(p); ++i) {
+		static thread_local std::vector< double > chromosome;
+		chromosome.assign(pop(i), pop(i) + n);
+		signatures[i] = refDecoder.signature(chromosome);
+	}
+
+	// Elites keep their place (they are distinct after the previous generation); offspring are
+	// checked in index order so the outcome does not depend on the number of threads:
+	std::unordered_set< unsigned long long > seen(signatures.begin(), signatures.begin() + pe);
+	std::vector< double > chromosome(n);
+	unsigned replaced = 0;
+
+	for(unsigned i = pe; i < p; ++i) {
+		if(!isRepeated(seen, signatures[i])) { continue; }
+		++replaced;
+
+		// Streams with bit 30 set are disjoint from the mating ones (k * p + i < 2^30):
+		Philox rng(seed, gen, (1u << 30) | (k * p + i));
+		for(unsigned attempt = 0; attempt < 4; ++attempt) {
+			rng.fill(pop(i), n);
+			chromosome.assign(pop(i), pop(i) + n);
+			if(!isRepeated(seen, refDecoder.signature(chromosome))) { break; }
+		}
+	}
+
+	duplicates[k] = replaced;
+	totalDuplicates[k] += replaced;
+}
+
+template< class Decoder, class RNG >
+inline void BRKGA< Decoder, RNG >::checkStagnation(const unsigned k, const uint32_t gen) {
+	const double best = current[k]->fitness[0].first;
+	if(best < bestSeen[k]) {
+		bestSeen[k] = best;
+		stagnant[k] = 0;
+		return;
+	}
+
+	if(++stagnant[k] < restartAfter) { return; }
+
+	restart(k, gen);
+	stagnant[k] = 0;
+
+	const RestartEvent event = { gen + 1, k, best };
+	restarts[k].push_back(event);
+}
+
+template< class Decoder, class RNG >
+inline void BRKGA< Decoder, RNG >::restart(const unsigned k, const uint32_t gen) {
+	// Same layout as evolution(): the kept elites go to the front of 'next', in rank order
+	Population& curr = *current[k];
+	Population& next = *previous[k];
+	for(unsigned i = 0; i < pe; ++i) {
+		std::memcpy(next(i), curr(curr.fitness[i].second), n * sizeof(double));
 
 		next.fitness[i].first = curr.fitness[i].first;
 		next.fitness[i].second = i;
-		++i;
+		next.refined[i] = curr.refined[curr.fitness[i].second];
 	}
 
-	// 3. We'll mate 'p - pe - pm' pairs; initially, i = pe, so we need to iterate until i < p - pm:
-	while(i < p - pm) {
-		// Select an elite parent:
-		const unsigned eliteParent = (refRNG.randInt(pe - 1));
+	// Streams with bit 29 set are disjoint from the mating and duplicate ones:
+	const unsigned first = (restartPerturbation > 0.0) ? 1 : pe;
+	#ifdef _OPENMP
+		#pragma omp parallel for num_threads(threads())
+	#endif
+	for(int i = int(first); i < int(p); ++i) {
+		Philox rng(seed, gen, (1u << 29) | (k * p + i));
+		double* chromosome = next(i);
 
-		// Select a non-elite parent:
-		const unsigned noneliteParent = pe + (refRNG.randInt(p - pe - 1));
+		if(unsigned(i) < pe) {
+			for(unsigned j = 0; j < n; ++j) {
+				if(rng.rand() < restartPerturbation) { chromosome[j] = rng.rand(); }
+			}
+		} else {
+			rng.fill(chromosome, n);
+		}
+	}
 
-		// Mate:
-		for(j = 0; j < n; ++j) {
-			const unsigned sourceParent = ((refRNG.rand() < rhoe) ? eliteParent : noneliteParent);
+	decodeAll(next, k, first, p);
+	rankPopulation(next);
+	if(intensifyK > 0) { intensify(next); }
 
-			next(i, j) = curr(curr.fitness[sourceParent].second, j);
+	std::swap(current[k], previous[k]);
+}
+
+template< class Decoder, class RNG >
+inline bool BRKGA< Decoder, RNG >::isRepeated(std::unordered_set< unsigned long long >& seen,
+		const unsigned long long signature) const {
+	return !seen.insert(signature).second;
+}
+
+template< class Decoder, class RNG >
+inline void BRKGA< Decoder, RNG >::intensify(Population& pop) {
+	// Refinement may reorder the top-k and let in chromosomes decoded cheaply (copied elites,
+	// injected or imported ones), so repeat until every one of the top-k is refined:
+	std::vector< unsigned > ranks;
+	while(true) {
+		ranks.clear();
+		for(unsigned r = 0; r < std::min(intensifyK, p); ++r) {
+			if(!pop.refined[pop.fitness[r].second]) { ranks.push_back(r); }
+		}
+		if(ranks.empty()) { break; }
 
-			//next(i, j) = (refRNG.rand() < rhoe) ? curr(curr.fitness[eliteParent].second, j) :
-			//		                              curr(curr.fitness[noneliteParent].second, j);
+		#ifdef _OPENMP
+			#pragma omp parallel for num_threads(threads())
+		#endif
+		for(int r = 0; r < int(ranks.size()); ++r) {
+			#pragma omp atomic
+            ++evaluations;
+			std::pair< double, unsigned >& entry = pop.fitness[ranks[r]];
+			entry.first = refine(pop, entry.second);
 		}
 
-		++i;
+		rankPopulation(pop);
 	}
+}
+
+template< class Decoder, class RNG >
+inline void BRKGA< Decoder, RNG >::decodeAll(Population& pop, const unsigned k, const unsigned first,
+		const unsigned last) {
+	const unsigned count = last - first;
+	const unsigned T = threads();
 
-	// We'll introduce 'pm' mutants:
-	while(i < p) {
-		for(j = 0; j < n; ++j) { next(i, j) = refRNG.rand(); }
-		++i;
+	// Longest-expected-first: sort by decreasing Decoder::cost()
+	std::vector< std::pair< double, unsigned > > order(count);
+	#ifdef _OPENMP
+		#pragma omp parallel for num_threads(T)
+	#endif
+	for(int i = 0; i < int(count); ++i) {
+		static thread_local std::vector< double > chromosome;
+		chromosome.assign(pop(first + i), pop(first + i) + n);
+		order[i] = std::make_pair(-refDecoder.cost(chromosome), first + i);
 	}
+	std::sort(order.begin(), order.end());
 
-	// Time to compute fitness, in parallel:
+	// Once, here: setFitness below runs on every thread and only writes its own entry
+	pop.invalidateRanking();
+
+	// Idle threads grab the next most expensive chromosome from the shared queue:
+	std::vector< double > busy(T, 0.0);
+	const double start = omp_get_wtime();
 	#ifdef _OPENMP
-		#pragma omp parallel for num_threads(MAX_THREADS)
+		#pragma omp parallel for num_threads(T) schedule(dynamic, 1)
 	#endif
-	for(int i = int(pe); i < int(p); ++i) {
+	for(int i = 0; i < int(count); ++i) {
+		const double begin = omp_get_wtime();
+		#pragma omp atomic
         ++evaluations;
-		next.setFitness( i, refDecoder.decode(next.population[i]) );
+		pop.setFitness(order[i].second, decode(pop, order[i].second));
+		busy[omp_get_thread_num()] += omp_get_wtime() - begin;
 	}
+	const double wall = omp_get_wtime() - start;
 
-	// Now we must sort 'current' by fitness, since things might have changed:
-//	exit(44);
-	next.sortFitness();
+	if(busyTime[k].size() < T) { busyTime[k].resize(T, 0.0); idleTime[k].resize(T, 0.0); }
+	for(unsigned t = 0; t < T; ++t) {
+		busyTime[k][t] += busy[t];
+		idleTime[k][t] += wall - busy[t];
+	}
+}
+
+template< class Decoder, class RNG >
+inline double BRKGA< Decoder, RNG >::decode(Population& pop, const unsigned i) const {
+	static thread_local std::vector< double > chromosome;
+	chromosome.assign(pop(i), pop(i) + n);
+
+	const double fitness = refDecoder.decode(chromosome);
+	std::memcpy(pop(i), chromosome.data(), n * sizeof(double));	// decode may repair band genes
+	publish(fitness, chromosome);
+	return fitness;
+}
+
+template< class Decoder, class RNG >
+inline double BRKGA< Decoder, RNG >::refine(Population& pop, const unsigned i) const {
+	static thread_local std::vector< double > chromosome;
+	chromosome.assign(pop(i), pop(i) + n);
+
+	const double fitness = refDecoder.intensify(chromosome);
+	std::memcpy(pop(i), chromosome.data(), n * sizeof(double));
+	pop.refined[i] = 1;
+	publish(fitness, chromosome);
+	return fitness;
 }
 
+template< class Decoder, class RNG >
+inline void BRKGA< Decoder, RNG >::publish(const double fitness, const std::vector< double >& chromosome) const {
+	// Most decodes are worse than the whole archive: skip the signature for those
+	if(archive == nullptr || !archive->admits(fitness)) { return; }
+	archive->publish(fitness, refDecoder.signature(chromosome), chromosome.data());
+}
+
+template< class Decoder, class RNG >
+const std::vector< double >& BRKGA< Decoder, RNG >::getBusyTime(unsigned k) const { return busyTime[k]; }
+
+template< class Decoder, class RNG >
+const std::vector< double >& BRKGA< Decoder, RNG >::getIdleTime(unsigned k) const { return idleTime[k]; }
+
+template< class Decoder, class RNG >
+unsigned BRKGA< Decoder, RNG >::getDuplicates(unsigned k) const { return duplicates[k]; }
+
+template< class Decoder, class RNG >
+unsigned long long BRKGA< Decoder, RNG >::getTotalDuplicates(unsigned k) const { return totalDuplicates[k]; }
+
+template< class Decoder, class RNG >
+unsigned BRKGA< Decoder, RNG >::getGeneration() const { return generation; }
+
+template< class Decoder, class RNG >
+const std::vector< RestartEvent >& BRKGA< Decoder, RNG >::getRestarts(unsigned k) const { return restarts[k]; }
+
+template< class Decoder, class RNG >
+const std::vector< ResizeEvent >& BRKGA< Decoder, RNG >::getResizes() const { return resizes; }
+
+template< class Decoder, class RNG >
+const std::vector< GenerationStats >& BRKGA< Decoder, RNG >::getParameterLog() const { return parameterLog; }
+
 template< class Decoder, class RNG >
 unsigned BRKGA<Decoder, RNG>::getN() const { return n; }
 
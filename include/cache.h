@@ -0,0 +1,31 @@
+#ifndef CACHE_H
+#define CACHE_H
+
+#include <bits/stdc++.h>
+#include "common.h"
+
+using namespace std;
+
+struct CacheStats {
+    ll hits;        // found in the calling thread's table
+    ll sharedHits;  // found in the shared table
+    ll misses;      // had to be evaluated
+
+    double hitRate() const;
+};
+
+// Off by default: a cached throughput is the one computed by the first thread that met the set of
+// links, in its own insertion order, so with the cache on fitness values may differ in the last bits
+// from run to run and between thread counts
+extern bool useChannelCache;    // per-thread tables
+extern bool shareChannelCache;  // also look up and publish into the table shared by all threads
+
+// Throughput of the channel holding 'key' at 'bandwidth', if it was evaluated before
+bool lookupChannel(const ChannelKey& key, int bandwidth, double& throughput);
+void storeChannel(const ChannelKey& key, int bandwidth, double throughput);
+
+// Invalidates every entry; loadData() calls it since the values depend on the instance
+void clearChannelCache();
+CacheStats channelCacheStats();
+
+#endif
@@ -35,12 +35,25 @@ struct Connection {
     bool operator>(const Connection &other) const;
 };
 
+// Order-independent key of a set of connection ids: channels holding the same links share it no
+// matter the order in which the links were inserted.
+struct ChannelKey {
+    unsigned long long sum;
+    unsigned long long mix;
+    int size;
+
+    ChannelKey();
+
+    void add(int id);
+};
+
 struct Channel {
     double throughput;
     double interference;
     double violation;
     int bandwidth;
     vector<Connection> connections; 
+    ChannelKey key;                 // kept in sync with 'connections' by insertInChannel/buildChannel
 
     Channel(double throughput, double interference, double violation, int bandwidth,
             const vector<Connection> connections);
@@ -71,25 +84,28 @@ struct TimeSlot {
 };
 
 
-extern int nConnections, nSpectrums, type;
+extern int nConnections, nSpectrums, type, nSlots;
 extern vector<vector<double>> dataRates, SINR, beta;
 
-extern double distanceMatrix[MAX_CONN][MAX_CONN];
-extern double interferenceMatrix[MAX_CONN][MAX_CONN];
+extern double (*distanceMatrix)[MAX_CONN];       // MAX_CONN x MAX_CONN
+extern double (*interferenceMatrix)[MAX_CONN];
 extern double senders[MAX_CONN][2];
 extern double receivers[MAX_CONN][2];
-extern double affectance[MAX_CONN][MAX_CONN];
+extern double (*affectance)[MAX_CONN];
 extern double powerSender, alfa, noise, ttm;
 
 
 extern vector<Spectrum> init_conf;
 extern vector<int> spectrum_size;
+extern TimeSlot slotTemplate;    // empty slot with the instance's spectra, copied by every decode
+extern double totalSpectrum;     // sum of the instance's spectrum sizes (MHz)
 
 inline double distance(double X_si, double Y_si, double X_ri, double Y_ri);
 void distanceAndInterference();
 double convertDBMToMW(double value);
 void convertTableToMW(const vector<vector<double>> &_SINR, vector<vector<double>> &_SINR_Mw);
 void initTimeSlot();
+void buildSlotTemplate();
 void loadData();
 
 #endif 
\ No newline at end of file
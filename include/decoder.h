@@ -29,7 +29,23 @@ class Solution {
     }
 
     double decode(vector<double>& variables) const;
+    double intensify(vector<double>& variables) const;
+    double cost(const vector<double>& variables) const;
+    unsigned long long signature(const vector<double>& variables) const;
     mutable ll count_debug = 0;
 };
 
+// Schedule of a chromosome, as decode builds it; with 'refined', each slot also goes through dp()
+Solution build(vector<double>& variables, bool refined);
+
+// Random keys that re-open the channels of 'sol' with their widths (one link per channel first,
+// band genes in the middle of their range) and leave the other links to insertBestFree. The
+// decoded schedule is close to 'sol' but not always equal (a few percent either way), since
+// insertBestFree picks each link's channel greedily
+vector<double> rebuildChromossome(const Solution& sol, int nVariables);
+
+// Chromosomes of constructive orderings (shortest link, lowest incoming affectance, highest solo
+// rate, angular sweep), each link with the band of its best noise-only rate
+vector<vector<double>> heuristicChromosomes(int nVariables);
+
 #endif
\ No newline at end of file
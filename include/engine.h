@@ -0,0 +1,103 @@
+#ifndef ENGINE_H
+#define ENGINE_H
+
+#include <bits/stdc++.h>
+#include "common.h"
+#include "brkga.h"
+#include "decoder.h"
+#include "shm.h"
+#include "MTRand.h"
+
+using namespace std;
+
+// How main runs the BRKGA besides p, pe, pm and rhoe. The tuner goes through the same functions,
+// so the configuration it races is the one main runs. Header-only, like brkga.h: include it in
+// one translation unit per program.
+const unsigned K = 1;
+const unsigned X_INTVL = 100;
+const unsigned X_NUMBER = 2;
+const unsigned INTENSIFY_K = 10;
+const bool STEADY_STATE = false;
+const unsigned RESTART_AFTER = 100;         // generations without improvement (0 ==> no restarts)
+const double RESTART_PERTURBATION = 0.1;
+const unsigned MP_PARENTS = 0;              // BRKGA-MP parents per offspring (0 ==> classic rhoe crossover)
+const unsigned MP_ELITE_PARENTS = 2;
+const bool HEURISTIC_SEEDS = true;          // seed with the constructive orderings of heuristicChromosomes
+const unsigned ARCHIVE_SIZE = 16;           // distinct best solutions kept by the elite archive
+const unsigned P_MIN = 40;                  // adaptive population size bounds (P_MIN = 0 ==> fixed p)
+const unsigned P_MAX = 200;                 // further capped at 2 * n, so small instances stay small
+const unsigned SIZE_WINDOW = 10;            // generations between population size decisions
+const unsigned SIZE_GRANULARITY = 8;        // p - pe stays a multiple of it, whatever the thread count
+const bool PARAMETER_CONTROL = true;        // adapt rhoe and pm every generation (see setParameterControl)
+const double RHOE_MIN = 0.55, RHOE_MAX = 0.85;
+const double PM_MIN = 0.05, PM_MAX = 0.20;
+
+unsigned pathRelinkSteps = 16;              // points decoded at each X_INTVL (0 ==> off), main's --path-relink
+
+typedef BRKGA<Solution, MTRand> Engine;
+
+// Intensification (type 4), partial ranking, duplicate elimination, adaptive size, parameter
+// control, the elite archive, multi-parent crossover and restarts, right after construction
+inline void configureEngine(Engine& algorithm, EliteArchive* archive) {
+    const unsigned p = algorithm.getP(), n = algorithm.getN();
+
+    if (type == 4) algorithm.setIntensification(INTENSIFY_K);
+    algorithm.setPartialRanking(true);
+    algorithm.setDuplicateElimination(true);
+    if (P_MIN > 0) algorithm.setAdaptiveSize(P_MIN, max(p, min(P_MAX, 2 * n)), SIZE_WINDOW, SIZE_GRANULARITY);
+    algorithm.setParameterControl(PARAMETER_CONTROL, RHOE_MIN, RHOE_MAX, PM_MIN, PM_MAX);
+    algorithm.setArchive(archive);
+    if (MP_PARENTS > 0) algorithm.setMultiParent(MP_PARENTS, MP_ELITE_PARENTS, BiasFunction::LOGINVERSE);
+    if (RESTART_AFTER > 0) algorithm.setRestart(RESTART_AFTER, RESTART_PERTURBATION);
+}
+
+// Injects the heuristic orderings and the warm start chromosomes of the engine's size (see
+// --warm-start); returns how many
+inline unsigned seedEngine(Engine& algorithm, const vector<vector<double>>& warmStart) {
+    const unsigned n = algorithm.getN();
+    const unsigned maxSeeds = algorithm.getP() / 2;     // the rest stay random for diversity
+
+    // Only chromosomes of this instance's size apply (solution.txt holds every instance)
+    vector<vector<double>> seeds;
+    if (HEURISTIC_SEEDS) seeds = heuristicChromosomes(n);
+
+    // Each one also seeds the keys of its dp-refined schedule, so every type starts from dp's channels
+    for (auto chromosome : warmStart) {
+        if (chromosome.size() != n) continue;
+        if (seeds.size() < maxSeeds) seeds.pb(chromosome);
+        if (seeds.size() < maxSeeds) seeds.pb(rebuildChromossome(build(chromosome, true), n));
+    }
+
+    algorithm.injectChromosomes(seeds);
+    return seeds.size();
+}
+
+// One generation; type 3 draws whether this one refines from 'rng' (the engine's own RNG)
+inline void evolveEngine(Engine& algorithm, MTRand& rng) {
+    // Drawn for every type, so the other types see the same random stream as type 3; only type 3
+    // reads 'refine', and only it writes it (the tuner runs other types side by side)
+    const bool refined = (rng.randInt(1) == 1);
+    if (type == 3) refine = refined;
+
+    if (STEADY_STATE) algorithm.evolveSteadyState(algorithm.getPo() + algorithm.getPm());
+    else algorithm.evolve();
+}
+
+// At every X_INTVL generations: elite exchange (with the other processes too, if any) and path relinking
+inline void exchangeEngine(Engine& algorithm, ProcessIslands* islands) {
+    algorithm.exchangeElite(X_NUMBER);
+
+    // Between processes: send our elite to the next island, take in what reached us
+    if (islands != nullptr) {
+        const Population& population = algorithm.getPopulation();
+        for (unsigned m = 0; m < X_NUMBER; m++)
+            islands->send(population.getFitness(m), population.getChromosome(m));
+        algorithm.importElite(islands->receive());
+    }
+
+    // A block is one link's (priority, band) gene pair
+    if (pathRelinkSteps > 0)
+        for (unsigned k = 0; k < K; k++) algorithm.pathRelink(2, pathRelinkSteps, k);
+}
+
+#endif
@@ -0,0 +1,126 @@
+/*
+ * Philox.h
+ *
+ * Counter-based random number generator Philox4x32-10 (Salmon et al., "Parallel random numbers:
+ * as easy as 1, 2, 3", SC'11). A stream is fully determined by a 64-bit key and a 64-bit stream
+ * id, so any thread can regenerate the numbers of any (seed, generation, individual) triple
+ * without sharing state: BRKGA uses it to mate offspring in parallel and still get the same
+ * population for every number of threads.
+ *
+ * It implements the subset of the RNG interface used by BRKGA:
+ *     - double rand() to return a double precision random deviate in range [0,1)
+ *     - unsigned long randInt() to return a 32-bit unsigned random deviate in range [0,2^32-1]
+ *     - unsigned long randInt(N) to return a unsigned random deviate in range [0, N] with N < 2^32
+ *
+ * plus fill(), which writes a whole buffer of uniforms at once. Blocks are independent functions of
+ * their counter, so that loop has no carried state and compiles to SIMD code.
+ */
+
+#ifndef PHILOX_H
+#define PHILOX_H
+
+#include <cstdint>
+
+class Philox {
+public:
+	/*
+	 * seed: 64-bit key of the generator
+	 * stream, substream: 32-bit coordinates of the stream (e.g., generation and individual)
+	 */
+	Philox(uint64_t seed, uint32_t stream, uint32_t substream);
+
+	double rand();							// real number in [0,1) with 53-bit resolution
+	unsigned long randInt();				// integer in [0,2^32-1]
+	unsigned long randInt(unsigned long n);	// integer in [0,n] for n < 2^32
+	void fill(double* out, unsigned count);	// 'count' reals in [0,1), from the next whole blocks
+
+	// The 4 words of block 'index' of the stream; the generator state is left untouched
+	void block(uint64_t index, uint32_t out[4]) const;
+
+private:
+	uint32_t key[2];
+	uint32_t stream[2];
+	uint64_t index;		// next block
+	uint32_t buffer[4];
+	unsigned left;		// unused words in 'buffer'
+
+	static double toDouble(uint32_t a, uint32_t b);
+	static void rounds(uint32_t& c0, uint32_t& c1, uint32_t& c2, uint32_t& c3, uint32_t k0, uint32_t k1);
+};
+
+inline Philox::Philox(uint64_t seed, uint32_t s, uint32_t ss) : index(0), left(0) {
+	key[0] = uint32_t(seed);
+	key[1] = uint32_t(seed >> 32);
+	stream[0] = s;
+	stream[1] = ss;
+}
+
+inline void Philox::rounds(uint32_t& c0, uint32_t& c1, uint32_t& c2, uint32_t& c3, uint32_t k0,
+		uint32_t k1) {
+	#pragma GCC unroll 10
+	for(int round = 0; round < 10; ++round) {
+		const uint64_t p0 = uint64_t(0xD2511F53u) * c0;
+		const uint64_t p1 = uint64_t(0xCD9E8D57u) * c2;
+
+		const uint32_t n0 = uint32_t(p1 >> 32) ^ c1 ^ k0;
+		const uint32_t n2 = uint32_t(p0 >> 32) ^ c3 ^ k1;
+		c1 = uint32_t(p1);
+		c3 = uint32_t(p0);
+		c0 = n0;
+		c2 = n2;
+
+		k0 += 0x9E3779B9u;
+		k1 += 0xBB67AE85u;
+	}
+}
+
+inline void Philox::block(uint64_t i, uint32_t out[4]) const {
+	uint32_t c0 = uint32_t(i), c1 = uint32_t(i >> 32), c2 = stream[0], c3 = stream[1];
+	rounds(c0, c1, c2, c3, key[0], key[1]);
+	out[0] = c0; out[1] = c1; out[2] = c2; out[3] = c3;
+}
+
+inline unsigned long Philox::randInt() {
+	if(left == 0) { block(index++, buffer); left = 4; }
+	return buffer[4 - left--];
+}
+
+inline unsigned long Philox::randInt(unsigned long n) {
+	// Multiply-shift: the bias is below 2^-32 * (n + 1), negligible for population indices
+	return (unsigned long)((uint64_t(randInt()) * (uint64_t(n) + 1)) >> 32);
+}
+
+inline double Philox::toDouble(uint32_t a, uint32_t b) {
+	return ((a >> 5) * 67108864.0 + (b >> 6)) * (1.0 / 9007199254740992.0);	// as MTRand::rand53
+}
+
+inline double Philox::rand() {
+	const uint32_t a = randInt();
+	return toDouble(a, randInt());
+}
+
+inline void Philox::fill(double* out, unsigned count) {
+	// Two doubles per block, starting from the next block (words buffered by rand() are dropped):
+	const unsigned pairs = count / 2;
+	const uint64_t first = index;
+	#ifdef _OPENMP
+		#pragma omp simd
+	#endif
+	for(unsigned b = 0; b < pairs; ++b) {
+		uint32_t c0 = uint32_t(first + b), c1 = uint32_t((first + b) >> 32), c2 = stream[0], c3 = stream[1];
+		rounds(c0, c1, c2, c3, key[0], key[1]);
+		out[2 * b] = toDouble(c0, c1);
+		out[2 * b + 1] = toDouble(c2, c3);
+	}
+
+	if(count & 1) {
+		uint32_t words[4];
+		block(first + pairs, words);
+		out[count - 1] = toDouble(words[0], words[1]);
+	}
+
+	index += (count + 1) / 2;
+	left = 0;
+}
+
+#endif
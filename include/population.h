@@ -6,6 +6,10 @@
  * fitness of a specific chromosome as well as access methods to each allele. Note that the BRKGA
  * class must have access to such methods and thus is a friend.
  *
+ * All p chromosomes live in a single contiguous buffer, one row of 'stride' doubles each; rows
+ * start on a cache line (n is padded up to a multiple of 8 doubles), so copying a chromosome is a
+ * memcpy and crossover streams through memory.
+ *
  *  Created on : Jun 21, 2010 by rtoso
  *  Last update: Nov 15, 2010 by rtoso
  *      Authors: Rodrigo Franco Toso <rtoso@cs.rutgers.edu>
@@ -16,9 +20,32 @@
 
 #include <vector>
 #include <algorithm>
+#include <cstring>
+#include <new>
 #include <exception>
 #include <stdexcept>
 
+// Minimal allocator returning 'Alignment'-byte aligned blocks (C++17 aligned operator new):
+template< class T, std::size_t Alignment >
+class AlignedAllocator {
+public:
+	typedef T value_type;
+	template< class U > struct rebind { typedef AlignedAllocator< U, Alignment > other; };
+
+	AlignedAllocator() {}
+	template< class U > AlignedAllocator(const AlignedAllocator< U, Alignment >&) {}
+
+	T* allocate(std::size_t count) {
+		return static_cast< T* >(::operator new(count * sizeof(T), std::align_val_t(Alignment)));
+	}
+	void deallocate(T* ptr, std::size_t) { ::operator delete(ptr, std::align_val_t(Alignment)); }
+};
+
+template< class T, class U, std::size_t A >
+bool operator==(const AlignedAllocator< T, A >&, const AlignedAllocator< U, A >&) { return true; }
+template< class T, class U, std::size_t A >
+bool operator!=(const AlignedAllocator< T, A >&, const AlignedAllocator< U, A >&) { return false; }
+
 class Population {
 	template< class Decoder, class RNG >
 	friend class BRKGA;
@@ -31,33 +58,51 @@ public:
 
 	// These methods REQUIRE fitness to be sorted, and thus a call to sortFitness() beforehand
 	// (this is done by BRKGA, so rest assured: everything will work just fine with BRKGA).
+	// After rankFitness(k), ranks >= k are served from a sorted copy built on first access
+	// (not thread-safe; meant for reporting between generations).
 	double getBestFitness() const;			// Returns the best fitness in this population
 	double getFitness(unsigned i) const;	// Returns the fitness of chromosome i
-	const std::vector< double >& getChromosome(unsigned i) const;	// Returns i-th best chromosome
+	const double* getChromosome(unsigned i) const;	// Returns i-th best chromosome (n alleles)
 
 private:
 	Population(const Population& other);
 	Population(unsigned n, unsigned p);
 	~Population();
 
-	std::vector< std::vector< double > > population;		// Population as vectors of prob.
+	unsigned n;			// Alleles per chromosome
+	unsigned p;			// Chromosomes
+	unsigned stride;	// Doubles between consecutive chromosomes (n rounded up to a cache line)
+
+	std::vector< double, AlignedAllocator< double, 64 > > population;	// p rows of 'stride' alleles
 	std::vector< std::pair< double, unsigned > > fitness;	// Fitness (double) of a each chromosome
+	unsigned ranked;	// leading entries of 'fitness' known to be in sorted order
+	std::vector< char > refined;	// per row: its fitness comes from Decoder::intensify()
+
+	mutable std::vector< std::pair< double, unsigned > > sorted;	// fully sorted copy of 'fitness'
+	mutable bool sortedValid;
 
 	void sortFitness();									// Sorts 'fitness' by its first parameter
-	void setFitness(unsigned i, double f);				// Sets the fitness of chromosome i
-	std::vector< double >& getChromosome(unsigned i);	// Returns a chromosome
+	void rankFitness(unsigned k);						// Sorts only the k best, ahead of the rest
+	const std::pair< double, unsigned >& rank(unsigned i) const;	// i-th best (fitness, index)
+	void setFitness(unsigned i, double f);				// Sets the (unrefined) fitness of chromosome i
+	void invalidateRanking();							// Call before setFitness (not thread-safe)
+	void resize(unsigned p);	// keeps the first min(p, getP()) entries of 'fitness', see below
+	double* getChromosome(unsigned i);					// Returns a chromosome
 
 	double& operator()(unsigned i, unsigned j);		// Direct access to allele j of chromosome i
-	std::vector< double >& operator()(unsigned i);	// Direct access to chromosome i
+	double* operator()(unsigned i);					// Direct access to chromosome i
+	const double* operator()(unsigned i) const;
 };
 
 Population::Population(const Population& pop) :
+		n(pop.n), p(pop.p), stride(pop.stride),
 		population(pop.population),
-		fitness(pop.fitness) {
+		fitness(pop.fitness), ranked(pop.ranked), refined(pop.refined), sortedValid(false) {
 }
 
-Population::Population(const unsigned n, const unsigned p) :
-		population(p, std::vector< double >(n, 0.0)), fitness(p) {
+Population::Population(const unsigned _n, const unsigned _p) :
+		n(_n), p(_p), stride((_n + 7) & ~7u), population(std::size_t(stride) * _p, 0.0), fitness(_p),
+		ranked(0), refined(_p, 0), sortedValid(false) {
 	if(p == 0) { throw std::range_error("Population size p cannot be zero."); }
 	if(n == 0) { throw std::range_error("Chromosome size n cannot be zero."); }
 }
@@ -66,11 +111,11 @@ Population::~Population() {
 }
 
 unsigned Population::getN() const {
-	return population[0].size();
+	return n;
 }
 
 unsigned Population::getP() const {
-	return population.size();
+	return p;
 }
 
 double Population::getBestFitness() const {
@@ -78,24 +123,78 @@ double Population::getBestFitness() const {
 }
 
 double Population::getFitness(unsigned i) const {
-	return fitness[i].first;
+	return rank(i).first;
 }
 
-const std::vector< double >& Population::getChromosome(unsigned i) const {
-	return population[ fitness[i].second ];
+const double* Population::getChromosome(unsigned i) const {
+	return (*this)(rank(i).second);
 }
 
-std::vector< double >& Population::getChromosome(unsigned i) {
-	return population[ fitness[i].second ];
+double* Population::getChromosome(unsigned i) {
+	return (*this)(fitness[i].second);
 }
 
 void Population::setFitness(unsigned i, double f) {
 	fitness[i].first = f;
 	fitness[i].second = i;
+	refined[i] = 0;
+}
+
+void Population::invalidateRanking() {
+	ranked = 0;
+	sortedValid = false;
+}
+
+// Rows are compacted in 'fitness' order, so entry i refers to row i afterwards; new rows are zeroed
+// and their entries must be set (setFitness) before ranking again
+void Population::resize(const unsigned _p) {
+	if(_p == 0) { throw std::range_error("Population size p cannot be zero."); }
+
+	const unsigned kept = std::min(p, _p);
+	std::vector< double, AlignedAllocator< double, 64 > > rows(std::size_t(stride) * _p, 0.0);
+	std::vector< char > flags(_p, 0);
+	for(unsigned i = 0; i < kept; ++i) {
+		std::memcpy(rows.data() + std::size_t(i) * stride, (*this)(fitness[i].second), n * sizeof(double));
+		flags[i] = refined[fitness[i].second];
+		fitness[i].second = i;
+	}
+
+	population.swap(rows);
+	refined.swap(flags);
+	fitness.resize(_p);
+	for(unsigned i = kept; i < _p; ++i) { fitness[i] = std::make_pair(0.0, i); }
+
+	p = _p;
+	ranked = std::min(ranked, kept);
+	sortedValid = false;
 }
 
 void Population::sortFitness() {
 	sort(fitness.begin(), fitness.end());
+	ranked = p;
+	sortedValid = false;
+}
+
+void Population::rankFitness(unsigned k) {
+	if(k >= p) { sortFitness(); return; }
+
+	// Everything before position k is no worse than everything after it; only that block is sorted:
+	std::nth_element(fitness.begin(), fitness.begin() + k, fitness.end());
+	std::sort(fitness.begin(), fitness.begin() + k);
+	ranked = k;
+	sortedValid = false;
+}
+
+const std::pair< double, unsigned >& Population::rank(unsigned i) const {
+	if(i < ranked) { return fitness[i]; }
+
+	if(!sortedValid) {
+		sorted = fitness;
+		std::sort(sorted.begin() + ranked, sorted.end());
+		sortedValid = true;
+	}
+
+	return sorted[i];
 }
 
 //double Population::operator()(unsigned chromosome, unsigned allele) const {
@@ -103,11 +202,15 @@ void Population::sortFitness() {
 //}
 
 double& Population::operator()(unsigned chromosome, unsigned allele) {
-	return population[chromosome][allele];
+	return population[std::size_t(chromosome) * stride + allele];
+}
+
+double* Population::operator()(unsigned chromosome) {
+	return population.data() + std::size_t(chromosome) * stride;
 }
 
-std::vector< double >& Population::operator()(unsigned chromosome) {
-	return population[chromosome];
+const double* Population::operator()(unsigned chromosome) const {
+	return population.data() + std::size_t(chromosome) * stride;
 }
 
 #endif
@@ -0,0 +1,98 @@
+#ifndef SHM_H
+#define SHM_H
+
+#include <bits/stdc++.h>
+#include <sys/types.h>
+#include "common.h"
+
+using namespace std;
+
+// Anonymous POSIX shared memory segment: unlinked as soon as it is mapped, it is shared with the
+// processes forked afterwards and vanishes with the last of them
+class SharedSegment {
+  public:
+    explicit SharedSegment(size_t bytes);
+    ~SharedSegment();
+
+    SharedSegment(const SharedSegment&) = delete;
+    SharedSegment& operator=(const SharedSegment&) = delete;
+
+    char* data() const { return memory; }
+    size_t size() const { return bytes; }
+
+  private:
+    char* memory;
+    size_t bytes;
+};
+
+// Moves distanceMatrix, interferenceMatrix and affectance into a shared segment, so processes
+// forked after loadData() read the same physical pages; call once, before loadData()
+void shareInstance();
+
+// Maps the shared instance read-only in the calling process: a stray write faults in that process
+// instead of corrupting the instance of all the others
+void protectInstance();
+
+// Bounded lock-free MPMC queue of (fitness, chromosome) records over shared memory (Vyukov's
+// bounded queue: a sequence number per cell orders producers and consumers without locks)
+class ChromosomeRing {
+  public:
+    static size_t bytes(unsigned capacity, unsigned n);
+
+    // 'memory' holds bytes(capacity, n) bytes; exactly one process initializes it
+    ChromosomeRing(char* memory, unsigned capacity, unsigned n, bool initialize);
+
+    bool push(double fitness, const double* chromosome);  // false if full
+    bool pop(double& fitness, double* chromosome);        // false if empty
+
+  private:
+    struct Header;
+    struct Cell;
+
+    Header* header;
+    char* cells;
+    unsigned capacity;  // power of two
+    unsigned n;
+    size_t cellBytes;
+
+    Cell* cell(unsigned long long position) const;
+};
+
+// Local coordinator of an island model with one solver process per island. Islands send elite
+// chromosomes to the next one on a ring through a ChromosomeRing each, and report their best
+// solution back to the coordinator in a shared result slot.
+class ProcessIslands {
+  public:
+    ProcessIslands(unsigned processes, unsigned n, unsigned migrants);
+
+    // Forks the islands: returns the island index in each child, which is pinned to its own
+    // block of CPUs, and -1 in the coordinator
+    int spawn();
+    unsigned threads() const { return islandThreads; }
+
+    // Island side
+    void send(double fitness, const double* chromosome);        // to the next island
+    vector<pair<double, vector<double>>> receive();               // everything queued for us
+    void publish(double fitness, const vector<double>& chromosome, ll evaluations, double timeToBest);
+
+    // Coordinator side: waits for every island and returns the best one that finished (-1 if none)
+    int wait();
+    double fitness(int island) const;
+    vector<double> chromosome(int island) const;
+    ll evaluations(int island) const;
+    double timeToBest(int island) const;
+
+  private:
+    struct Result;
+
+    unsigned processes, n, capacity, islandThreads;
+    int island;
+    vector<pid_t> children;
+    size_t ringBytes, resultBytes;
+    SharedSegment segment;
+
+    ChromosomeRing ring(unsigned i, bool initialize = false) const;
+    Result* result(unsigned i) const;
+};
+
+#endif
@@ -9,42 +9,35 @@ def plot_population_cloud(file_path):
     """
     try:
         # Carrega os dados
-        # Cada linha é uma geração, cada coluna é um indivíduo
-        data = np.loadtxt(file_path)
-        
-        # Verifica se o arquivo não está vazio ou mal formatado
-        if data.ndim == 1:
-            # Caso tenha apenas 1 geração, transforma em 2D para a lógica funcionar
-            data = data.reshape(1, -1)
+        # Cada linha é uma geração, cada coluna é um indivíduo. Com o tamanho adaptativo
+        # (setAdaptiveSize) o número de indivíduos varia entre gerações, então as linhas
+        # podem ter tamanhos diferentes e np.loadtxt não serve
+        with open(file_path) as f:
+            rows = [np.array(line.split(), dtype=float) for line in f if line.strip()]
             
-        if data.size == 0:
+        if not rows:
             print(f"Aviso: Arquivo vazio ignorado -> {file_path}")
             return
 
-        num_generations, pop_size = data.shape
-        
         # Parâmetros baseados no seu código C++
         # pe = 0.25, então os primeiros 25% (ordenados) são elite
         pe = 0.05
-        num_elite = int(pop_size * pe)
 
-        # Separação dos dados
+        # Separação dos dados, geração a geração
         # O BRKGA mantém a população ordenada, então os primeiros índices são os melhores
-        elite_data = data[:, :num_elite]      # Primeiras colunas (Melhores/Elite)
-        non_elite_data = data[:, num_elite:]  # Restante das colunas
-        
-        # Criação do Eixo X (Gerações)
-        # Repetimos o número da geração para cada indivíduo para poder plotar o scatter
-        generations = np.arange(num_generations)
-        
-        # Prepara arrays "achatados" (flatten) para plotagem em massa
-        # X para elite: repete o índice da geração para cada membro da elite
-        x_elite = np.repeat(generations, elite_data.shape[1])
-        y_elite = elite_data.flatten()
-        
-        # X para não-elite
-        x_non_elite = np.repeat(generations, non_elite_data.shape[1])
-        y_non_elite = non_elite_data.flatten()
+        x_elite, y_elite, x_non_elite, y_non_elite = [], [], [], []
+        for generation, row in enumerate(rows):
+            num_elite = int(len(row) * pe)
+            
+            # X: repete o índice da geração para cada indivíduo para poder plotar o scatter
+            x_elite.append(np.full(num_elite, generation))
+            y_elite.append(row[:num_elite])             # Primeiras colunas (Melhores/Elite)
+            x_non_elite.append(np.full(len(row) - num_elite, generation))
+            y_non_elite.append(row[num_elite:])         # Restante das colunas
+
+        # Prepara arrays "achatados" para plotagem em massa
+        x_elite, y_elite = np.concatenate(x_elite), np.concatenate(y_elite)
+        x_non_elite, y_non_elite = np.concatenate(x_non_elite), np.concatenate(y_non_elite)
 
         # --- Plotagem ---
         plt.figure(figsize=(12, 6))
@@ -0,0 +1,162 @@
+#include "../include/cache.h"
+
+bool useChannelCache = false;
+bool shareChannelCache = false;
+
+namespace {
+
+const int LOCAL_BITS = 14;      // 16k entries (640 KB) per thread
+const int SHARED_BITS = 16;     // 64k entries shared by all threads
+const int SHARED_STRIPES = 64;
+
+struct Entry {
+    unsigned long long sum;
+    unsigned long long mix;
+    int size;
+    int bandwidth;
+    unsigned epoch;             // 0 never matches: the table starts zeroed
+    double throughput;
+};
+
+struct Counters {
+    atomic<ll> hits, sharedHits, misses;
+
+    Counters() : hits(0), sharedHits(0), misses(0) {}
+};
+
+// Counters outlive their thread so channelCacheStats() can still report them
+mutex registryMutex;
+vector<shared_ptr<Counters>> registry;
+
+atomic<unsigned> epoch(1);
+
+struct LocalCache {
+    vector<Entry> table;
+    shared_ptr<Counters> counters;
+
+    LocalCache() : table(1 << LOCAL_BITS), counters(make_shared<Counters>()) {
+        lock_guard<mutex> lock(registryMutex);
+        registry.pb(counters);
+    }
+};
+
+struct SharedCache {
+    vector<Entry> table;
+    shared_mutex stripes[SHARED_STRIPES];
+
+    SharedCache() : table(1 << SHARED_BITS) {}
+};
+
+LocalCache& localCache() {
+    thread_local LocalCache cache;
+    return cache;
+}
+
+SharedCache& sharedCache() {
+    static SharedCache cache;
+    return cache;
+}
+
+inline unsigned long long splitmix(unsigned long long x) {
+    x += 0x9e3779b97f4a7c15ull;
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ull;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111ebull;
+    return x ^ (x >> 31);
+}
+
+inline unsigned long long slotHash(const ChannelKey& key, int bandwidth) {
+    return splitmix(key.sum ^ ((key.mix << 17) | (key.mix >> 47)) ^
+                    ((unsigned long long)bandwidth << 32) ^ (unsigned long long)key.size);
+}
+
+inline bool matches(const Entry& e, const ChannelKey& key, int bandwidth, unsigned ep) {
+    return e.epoch == ep && e.sum == key.sum && e.mix == key.mix && e.size == key.size &&
+           e.bandwidth == bandwidth;
+}
+
+inline Entry makeEntry(const ChannelKey& key, int bandwidth, unsigned ep, double throughput) {
+    return Entry{key.sum, key.mix, key.size, bandwidth, ep, throughput};
+}
+
+// Only the owning thread writes its counters, so a relaxed load/store pair is enough
+inline void bump(atomic<ll>& counter) {
+    counter.store(counter.load(memory_order_relaxed) + 1, memory_order_relaxed);
+}
+
+}
+
+double CacheStats::hitRate() const {
+    ll total = hits + sharedHits + misses;
+    return total == 0 ? 0.0 : double(hits + sharedHits) / total;
+}
+
+bool lookupChannel(const ChannelKey& key, int bandwidth, double& throughput) {
+    if (!useChannelCache) return false;
+
+    LocalCache& cache = localCache();
+    unsigned ep = epoch.load(memory_order_relaxed);
+    unsigned long long h = slotHash(key, bandwidth);
+
+    Entry& entry = cache.table[h & ((1ull << LOCAL_BITS) - 1)];
+    if (matches(entry, key, bandwidth, ep)) {
+        bump(cache.counters->hits);
+        throughput = entry.throughput;
+        return true;
+    }
+
+    if (shareChannelCache) {
+        SharedCache& shared = sharedCache();
+        size_t index = h >> (64 - SHARED_BITS);
+
+        shared_lock<shared_mutex> lock(shared.stripes[index % SHARED_STRIPES]);
+        if (matches(shared.table[index], key, bandwidth, ep)) {
+            entry = shared.table[index];
+            bump(cache.counters->sharedHits);
+            throughput = entry.throughput;
+            return true;
+        }
+    }
+
+    bump(cache.counters->misses);
+    return false;
+}
+
+void storeChannel(const ChannelKey& key, int bandwidth, double throughput) {
+    if (!useChannelCache) return;
+
+    unsigned ep = epoch.load(memory_order_relaxed);
+    unsigned long long h = slotHash(key, bandwidth);
+    localCache().table[h & ((1ull << LOCAL_BITS) - 1)] = makeEntry(key, bandwidth, ep, throughput);
+
+    if (shareChannelCache) {
+        SharedCache& shared = sharedCache();
+        size_t index = h >> (64 - SHARED_BITS);
+
+        unique_lock<shared_mutex> lock(shared.stripes[index % SHARED_STRIPES]);
+        shared.table[index] = makeEntry(key, bandwidth, ep, throughput);
+    }
+}
+
+void clearChannelCache() {
+    epoch.fetch_add(1);
+
+    lock_guard<mutex> lock(registryMutex);
+    for (auto& counters : registry) {
+        counters->hits = 0;
+        counters->sharedHits = 0;
+        counters->misses = 0;
+    }
+}
+
+CacheStats channelCacheStats() {
+    CacheStats stats = {0, 0, 0};
+
+    lock_guard<mutex> lock(registryMutex);
+    for (const auto& counters : registry) {
+        stats.hits += counters->hits.load(memory_order_relaxed);
+        stats.sharedHits += counters->sharedHits.load(memory_order_relaxed);
+        stats.misses += counters->misses.load(memory_order_relaxed);
+    }
+
+    return stats;
+}
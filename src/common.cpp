@@ -1,19 +1,27 @@
 #include "../include/common.h"
+#include "../include/cache.h"
 
-double distanceMatrix[MAX_CONN][MAX_CONN];
-double interferenceMatrix[MAX_CONN][MAX_CONN];
+// The big matrices live in static storage unless shareInstance() (shm.h) moves them to shared memory
+static double distanceStorage[MAX_CONN][MAX_CONN];
+static double interferenceStorage[MAX_CONN][MAX_CONN];
+static double affectanceStorage[MAX_CONN][MAX_CONN];
+
+double (*distanceMatrix)[MAX_CONN] = distanceStorage;
+double (*interferenceMatrix)[MAX_CONN] = interferenceStorage;
 double senders[MAX_CONN][2];
 double receivers[MAX_CONN][2];
-double affectance[MAX_CONN][MAX_CONN];
+double (*affectance)[MAX_CONN] = affectanceStorage;
 
 using namespace std;
 
-int nConnections, nSpectrums, type;
+int nConnections, nSpectrums, type, nSlots = 1;
 vector<vector<double>> dataRates, SINR, beta;
 double powerSender, alfa, noise, ttm;
 
 vector<Spectrum> init_conf;
 vector<int> spectrum_size;
+TimeSlot slotTemplate;
+double totalSpectrum = 0.0;
 bool refine = false;
 
 Connection::Connection(int id, double throughput, double interference, double distanceSR)
@@ -32,10 +40,25 @@ bool Connection::operator<(const Connection &other) const { return distanceSR <
 bool Connection::operator>(const Connection &other) const { return !operator<(other); }
 
 
+ChannelKey::ChannelKey() : sum(0), mix(0), size(0) {}
+
+void ChannelKey::add(int id) {
+    unsigned long long x = id + 0x9e3779b97f4a7c15ull;
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ull;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111ebull;
+    x ^= x >> 31;
+
+    sum += x;
+    mix ^= x * 0xff51afd7ed558ccdull + (x >> 29);
+    size++;
+}
+
 Channel::Channel(double throughput, double interference, double violation, int bandwidth,
         const vector<Connection> connections)
     : throughput(throughput), interference(interference), violation(violation),
-      bandwidth(bandwidth), connections(connections) {}
+      bandwidth(bandwidth), connections(connections) {
+    for (const auto &connection : connections) key.add(connection.id);
+}
 
 Channel::Channel(int bandwidth) : Channel(0.0, 0.0, 0.0, bandwidth, vector<Connection>()) {}
 
@@ -57,7 +80,10 @@ Spectrum::Spectrum() {
     channels = ::vector<Channel>();
 }
 
-TimeSlot::TimeSlot(const ::vector<Spectrum> sp) : spectrums(sp) {}
+TimeSlot::TimeSlot(const ::vector<Spectrum> sp) : spectrums(sp) {
+    interference = 0.0;
+    throughput = 0.0;
+}
 TimeSlot::TimeSlot() {
     interference = 0.0;
     throughput = 0.0;
@@ -111,7 +137,22 @@ void initTimeSlot() {
     }
 }
 
+void buildSlotTemplate() {
+    vector<Spectrum> spectrums;
+    totalSpectrum = 0.0;
+
+    for (int s : spectrum_size) {
+        spectrums.emplace_back(s, 0, vector<Channel>());
+        totalSpectrum += s;
+    }
+
+    slotTemplate = TimeSlot(spectrums);
+}
+
 void loadData(){
+    spectrum_size.clear();
+    init_conf.clear();
+
     cin >> nConnections >> alfa >> noise >> powerSender >> nSpectrums;
     for (int i = 0; i < nSpectrums; i++) {
         int s; cin >> s;
@@ -147,6 +188,8 @@ void loadData(){
     convertTableToMW(SINR, SINR);
     distanceAndInterference();
     initTimeSlot();
+    buildSlotTemplate();
+    clearChannelCache();
 
     for (int i = 0; i < nConnections; i++) {
         for (int j = 0; j < nConnections; j++) {
@@ -1,4 +1,5 @@
 #include "../include/decoder.h"
+#include "../include/cache.h"
 #include "../include/MTRand.h" 
 
 bool approximatelyEqual(double a, double b, double epsilon = EPS) {
@@ -48,6 +49,7 @@ Channel insertInChannel(Channel newChannel, int id){
     }
 
     newChannel.connections.emplace_back(connectionToInsert);
+    newChannel.key.add(id);
     newChannel.violation = newChannel.throughput = 0.0;
 
     for(auto& connection: newChannel.connections){
@@ -58,6 +60,28 @@ Channel insertInChannel(Channel newChannel, int id){
     return newChannel;
 }
 
+Channel buildChannel(const vector<int>& ids, int bandwidth){
+    Channel channel(bandwidth);
+    for(int id : ids){
+        channel.connections.emplace_back(id, 0.0, 0.0, distanceMatrix[id][id]);
+        channel.key.add(id);
+    }
+
+    // Same accumulation order as inserting 'ids' one by one with insertInChannel
+    for(auto& connection: channel.connections){
+        for(auto& other: channel.connections){
+            if(other.id != connection.id) connection.interference += affectance[connection.id][other.id];
+        }
+    }
+
+    for(auto& connection: channel.connections){
+        computeConnectionThroughput(connection, bandwidth);
+        channel.throughput += connection.throughput;
+    }
+
+    return channel;
+}
+
 double insertNextFree(Solution& sol, int idConnection, int band, vector<double>& variables){
     int freeSpec = 0, maxSpec = 0, indexMaxSpec = 0, indexMaxSlotSpec = 0, auxBand = -1;
     bool inserted = false;
@@ -106,20 +130,36 @@ double insertNextFree(Solution& sol, int idConnection, int band, vector<double>&
 
 void insertBestFree(Solution& sol, int idConnection, int band, vector<double>& variables){
     double currentThroughput = sol.throughput, bestThroughput = sol.throughput;
-    bool inserted = false;
+    bool inserted = false, built = false;
     Channel newChannel(band);
     vector<int> tscBestThroughput(3, -1);
 
     for(int t = 0; t < sol.slots.size(); t++){
         for(int s = 0; s < sol.slots[t].spectrums.size(); s++){
             for(int c = 0; c < sol.slots[t].spectrums[s].channels.size(); c++){
+                const Channel& channel = sol.slots[t].spectrums[s].channels[c];
+
                 // Calcular o novo throughput baseado no canal atual da iteração (t, s, c)
-                Channel toInsert = insertInChannel(sol.slots[t].spectrums[s].channels[c], idConnection);
-                double aux = currentThroughput - sol.slots[t].spectrums[s].channels[c].throughput + toInsert.throughput;
+                ChannelKey key = channel.key;
+                key.add(idConnection);
+                double cached;
+                if(lookupChannel(key, channel.bandwidth, cached)){
+                    double aux = currentThroughput - channel.throughput + cached;
+                    if(aux > bestThroughput){
+                        bestThroughput = aux;
+                        inserted = true; built = false;
+                        tscBestThroughput = {t, s, c};
+                    }
+                    continue;
+                }
+
+                Channel toInsert = insertInChannel(channel, idConnection);
+                storeChannel(key, channel.bandwidth, toInsert.throughput);
+                double aux = currentThroughput - channel.throughput + toInsert.throughput;
                 if(aux > bestThroughput){
                     bestThroughput = aux;
                     newChannel = toInsert;
-                    inserted = true;
+                    inserted = built = true;
                     tscBestThroughput = {t, s, c};
                 }
             }
@@ -127,8 +167,10 @@ void insertBestFree(Solution& sol, int idConnection, int band, vector<double>& v
     }
 
     if(inserted){
-        sol.throughput = bestThroughput;
-        sol.slots[tscBestThroughput[0]].spectrums[tscBestThroughput[1]].channels[tscBestThroughput[2]] = newChannel;
+        Channel& oldChannel = sol.slots[tscBestThroughput[0]].spectrums[tscBestThroughput[1]].channels[tscBestThroughput[2]];
+        if(!built) newChannel = insertInChannel(oldChannel, idConnection);
+        sol.throughput = currentThroughput - oldChannel.throughput + newChannel.throughput;
+        oldChannel = newChannel;
         
         if(newChannel.bandwidth != band){
             if(newChannel.bandwidth==20)variables[(idConnection*2)+1] = (0+0.25)/2.0;
@@ -217,11 +259,18 @@ Solution applyFusion(Solution sol) {
                     for(int j = i+1; j < n; j++){
                         if(spec.channels[j].bandwidth == a.bandwidth && a.bandwidth < 160){
                             b = spec.channels[j];
-                            Channel aux(a.bandwidth*2.0);
+
+                            // The same pair is revisited after every restart; skip known losers
+                            ChannelKey key = a.key;
+                            for(auto & conn : b.connections) key.add(conn.id);
+                            double merged;
+                            if(lookupChannel(key, a.bandwidth*2, merged) && merged <= a.throughput + b.throughput) continue;
+
                             vector<int> connection_ids;
                             for(auto & conn : a.connections) connection_ids.pb(conn.id);
                             for(auto & conn : b.connections) connection_ids.pb(conn.id);
-                            for(auto & id : connection_ids) aux = insertInChannel(aux, id);
+                            Channel aux = buildChannel(connection_ids, a.bandwidth*2);
+                            storeChannel(key, aux.bandwidth, aux.throughput);
                             if(aux.throughput > a.throughput + b.throughput){
                                 spec.channels.erase(spec.channels.begin() + j);
                                 spec.channels.erase(spec.channels.begin() + i);
@@ -250,8 +299,7 @@ pair<double, vector<Channel>> dfs(Channel channel, MTRand& rng){
 
     if(channel.bandwidth <= 20) return {channel.throughput, {channel}}; 
 
-    double newBand = channel.bandwidth / 2.0;
-    Channel a(newBand), b(newBand);
+    int newBand = channel.bandwidth / 2;
 
     int n = channel.connections.size();
     if (n == 0) return {0.0, {}};
@@ -266,11 +314,16 @@ pair<double, vector<Channel>> dfs(Channel channel, MTRand& rng){
         std::swap(connection_ids[i], connection_ids[j]);
     }
 
+    vector<int> ids_a, ids_b;
     for(int i = 0; i < n; i++){
-        if(i%2==0) a = insertInChannel(a, connection_ids[i]);
-        else b = insertInChannel(b, connection_ids[i]);
+        if(i%2==0) ids_a.pb(connection_ids[i]);
+        else ids_b.pb(connection_ids[i]);
     }
 
+    Channel a = buildChannel(ids_a, newBand), b = buildChannel(ids_b, newBand);
+    storeChannel(a.key, newBand, a.throughput);
+    storeChannel(b.key, newBand, b.throughput);
+
     pair<double, vector<Channel>> result_a = dfs(a, rng), result_b = dfs(b, rng);
 
     double children_throughput = result_a.first + result_b.first; 
@@ -316,47 +369,204 @@ Solution dp(Solution sol, MTRand& rng){
     return newSol;
 }
 
+Spectrum repackSpectrum(const Spectrum& spec){
+    const int units[] = {1, 2, 4, 8}; // 20, 40, 80 and 160 MHz
+    const double NEG = -1e18;
+
+    vector<Channel> channels;
+    for(const auto& channel : spec.channels) if(!channel.connections.empty()) channels.pb(channel);
+
+    int m = channels.size(), budget = spec.maxFrequency / 20;
+    if(m == 0) return Spectrum(spec.maxFrequency, 0, vector<Channel>());
+
+    // candidate[c][w]: throughput of the members of channel c with width 20 * units[w]
+    vector<vector<int>> ids(m);
+    vector<vector<double>> candidate(m, vector<double>(4));
+    for(int c = 0; c < m; c++){
+        const ChannelKey& key = channels[c].key;
+        for(const auto& conn : channels[c].connections) ids[c].pb(conn.id);
+        for(int w = 0; w < 4; w++){
+            int bandwidth = 20 * units[w];
+            if(bandwidth == channels[c].bandwidth) candidate[c][w] = channels[c].throughput;
+            else if(!lookupChannel(key, bandwidth, candidate[c][w])){
+                candidate[c][w] = buildChannel(ids[c], bandwidth).throughput;
+                storeChannel(key, bandwidth, candidate[c][w]);
+            }
+        }
+    }
+
+    // best[c][b]: max throughput of the first c channels using exactly b units of 20 MHz
+    vector<vector<double>> best(m + 1, vector<double>(budget + 1, NEG));
+    vector<vector<int>> choice(m + 1, vector<int>(budget + 1, -1));
+    best[0][0] = 0.0;
+
+    for(int c = 0; c < m; c++){
+        for(int b = 0; b <= budget; b++){
+            if(best[c][b] == NEG) continue;
+            for(int w = 0; w < 4; w++){
+                int nb = b + units[w];
+                if(nb > budget) break;
+                double value = best[c][b] + candidate[c][w];
+                if(value > best[c + 1][nb]){
+                    best[c + 1][nb] = value;
+                    choice[c + 1][nb] = w;
+                }
+            }
+        }
+    }
+
+    int bestBudget = -1;
+    for(int b = 0; b <= budget; b++){
+        if(best[m][b] != NEG && (bestBudget == -1 || best[m][b] > best[m][bestBudget])) bestBudget = b;
+    }
+    if(bestBudget == -1) return spec; // more channels than 20 MHz slices, keep it as it is
+
+    Spectrum repacked(spec.maxFrequency, 0, vector<Channel>());
+    for(int c = m, b = bestBudget; c > 0; c--){
+        int w = choice[c][b], bandwidth = 20 * units[w];
+        if(bandwidth == channels[c - 1].bandwidth) repacked.channels.pb(channels[c - 1]);
+        else repacked.channels.pb(buildChannel(ids[c - 1], bandwidth));
+        repacked.usedFrequency += bandwidth;
+        b -= units[w];
+    }
+    reverse(repacked.channels.begin(), repacked.channels.end());
+
+    return repacked;
+}
+
+// Re-chooses the width of every channel so each spectrum's capacity goes to where it pays the most
+Solution repack(Solution sol){
+    for(auto& slot : sol.slots){
+        for(auto& spec : slot.spectrums){
+            double before = 0.0, after = 0.0;
+            for(const auto& channel : spec.channels) before += channel.throughput;
+
+            spec = repackSpectrum(spec);
+
+            for(const auto& channel : spec.channels) after += channel.throughput;
+            sol.throughput += after - before;
+        }
+    }
+
+    return sol;
+}
+
 vector<double> rebuildChromossome(const Solution& sol, int nVariables) {
     vector<double> newVariables(nVariables, 0.5); 
-    
-    int totalConnections = 0;
-    for (const auto& slot : sol.slots)
-        for (const auto& spec : slot.spectrums)
-            for (const auto& channel : spec.channels)
-                totalConnections += channel.connections.size();
 
-    double priorityStep = 1.0 / (totalConnections + 1.0);
-    double currentPriority = priorityStep;
-
-    for (const auto& slot : sol.slots) {
-        for (const auto& spec : slot.spectrums) {
+    // Inside each slot, the first link of every channel comes first, in spectrum order, so
+    // insertNextFree re-opens the same channels with the same widths; the other links follow
+    // channel by channel and are left to insertBestFree
+    int nSlotsSol = sol.slots.size();
+    vector<vector<int>> order(nSlotsSol);
+    vector<bool> scheduled(nVariables / 2, false);
+    for (int t = 0; t < nSlotsSol; t++) {
+        vector<int> members;
+        for (const auto& spec : sol.slots[t].spectrums) {
             for (const auto& channel : spec.channels) {
-                
                 double newBandGene = 0.0;
                 if (channel.bandwidth == 20) newBandGene = 0.125;
                 else if (channel.bandwidth == 40) newBandGene = 0.375;
                 else if (channel.bandwidth == 80) newBandGene = 0.625;
                 else newBandGene = 0.875;
 
-                for (const auto& conn : channel.connections) {
-                    int id = conn.id;
-                    int priorityIndex = id * 2;
-                    int bandIndex = (id * 2) + 1;
-
-                    if (bandIndex < nVariables) {
-                        newVariables[bandIndex] = newBandGene;
-                        newVariables[priorityIndex] = currentPriority;
-                        
-                        currentPriority += priorityStep;
-                    }
+                for (int c = 0; c < channel.connections.size(); c++) {
+                    int id = channel.connections[c].id;
+                    if ((id * 2) + 1 >= nVariables) continue;
+                    newVariables[(id * 2) + 1] = newBandGene;
+                    scheduled[id] = true;
+                    (c == 0 ? order[t] : members).pb(id);
                 }
             }
         }
+        order[t].insert(order[t].end(), members.begin(), members.end());
     }
+
+    // Links the schedule left out go last, where insertBestFree may leave them out again
+    if (nSlotsSol > 0)
+        for (int id = 0; id < nVariables / 2; id++)
+            if (!scheduled[id]) order[nSlotsSol - 1].pb(id);
+
+    // Slot t owns the priority keys in [t / nSlots, (t + 1) / nSlots) (see slotOf)
+    for (int t = 0; t < nSlotsSol; t++)
+        for (int rank = 0; rank < order[t].size(); rank++)
+            newVariables[order[t][rank] * 2] = (t + (rank + 0.5) / order[t].size()) / nSlots;
     
     return newVariables;
 }
 
+// Rate of link 'id' alone on a channel of 'band' MHz: noise is then its only interference
+double soloRate(int id, int band){
+    double soloSINR = affectance[id][id] / noise;
+    int MCS = 11;
+    while(MCS >= 0 && soloSINR < SINR[MCS][bandIndex(band)]) MCS--;
+
+    return MCS < 0 ? 0.0 : dataRates[MCS][bandIndex(band)];
+}
+
+vector<vector<double>> heuristicChromosomes(int nVariables){
+    int n = nVariables / 2;
+    const int bands[] = {20, 40, 80, 160};
+    const double bandGenes[] = {0.125, 0.375, 0.625, 0.875};   // middle of each convertBand range
+
+    // Band with the highest noise-only rate (the narrower one on ties)
+    vector<double> bandGene(n), bestRate(n, 0.0);
+    for(int id = 0; id < n; id++){
+        bandGene[id] = bandGenes[0];
+        for(int b = 0; b < 4; b++){
+            double rate = soloRate(id, bands[b]);
+            if(rate > bestRate[id]) bestRate[id] = rate, bandGene[id] = bandGenes[b];
+        }
+    }
+
+    vector<double> incoming(n, 0.0);
+    for(int id = 0; id < n; id++)
+        for(int other = 0; other < n; other++)
+            if(other != id) incoming[id] += affectance[id][other];
+
+    double cx = 0.0, cy = 0.0;
+    for(int id = 0; id < n; id++) cx += senders[id][X_c], cy += senders[id][Y_c];
+    cx /= n, cy /= n;
+
+    vector<vector<int>> orders;
+
+    // Shortest link first
+    vector<Connection> connections;
+    for(int id = 0; id < n; id++) connections.emplace_back(id);
+    stable_sort(connections.begin(), connections.end());
+    orders.pb({});
+    for(const auto& connection : connections) orders.back().pb(connection.id);
+
+    vector<int> ids(n);
+    iota(ids.begin(), ids.end(), 0);
+
+    // Lowest aggregate incoming affectance first
+    orders.pb(ids);
+    stable_sort(orders.back().begin(), orders.back().end(), [&](int a, int b){ return incoming[a] < incoming[b]; });
+
+    // Highest solo rate first
+    orders.pb(ids);
+    stable_sort(orders.back().begin(), orders.back().end(), [&](int a, int b){ return bestRate[a] > bestRate[b]; });
+
+    // Angular sweep of the senders around their centroid
+    orders.pb(ids);
+    stable_sort(orders.back().begin(), orders.back().end(), [&](int a, int b){
+        return atan2(senders[a][Y_c] - cy, senders[a][X_c] - cx) < atan2(senders[b][Y_c] - cy, senders[b][X_c] - cx);
+    });
+
+    vector<vector<double>> chromosomes;
+    for(const auto& order : orders){
+        vector<double> variables(nVariables, 0.5);
+        for(int r = 0; r < n; r++){
+            variables[2 * order[r]] = (r + 0.5) / n;
+            variables[2 * order[r] + 1] = bandGene[order[r]];
+        }
+        chromosomes.pb(variables);
+    }
+
+    return chromosomes;
+}
+
 Solution verify(vector<double>& variables){
     int n = variables.size();
 
@@ -369,13 +579,8 @@ Solution verify(vector<double>& variables){
 
     sort(links.begin(), links.end());
 
-    vector<Channel> aux;
-    Spectrum spec1(160, 0, aux);
-    Spectrum spec2(240, 0, aux);
-    Spectrum spec3(100, 0, aux);
-
-    Solution sol ({spec1, spec2, spec3}, 0.0);
-    double totalSpectrum = 500.0, totalUsed = 0.0;
+    Solution sol (vector<TimeSlot>(1, slotTemplate));
+    double totalUsed = 0.0;
 
     int i = 0;
     while(i < links.size() && totalUsed < totalSpectrum){
@@ -395,30 +600,13 @@ Solution verify(vector<double>& variables){
     return sol;
 }
 
-double Solution::decode(vector<double>& variables) const {
-    int n = variables.size();
-
-    vector<vector<double>> links(n/2);
-
-    for(int i = 0; i < n; i+=2){
-        double k1 = variables[i];
-        links[i/2].push_back(k1); links[i/2].push_back(i);
-    }
-
-    sort(links.begin(), links.end());
-
-    vector<Channel> aux;
-    Spectrum spec1(160, 0, aux);
-    Spectrum spec2(240, 0, aux);
-    Spectrum spec3(100, 0, aux);
-
-    Solution sol ({spec1, spec2, spec3}, 0.0);
-    double totalSpectrum = 500.0, totalUsed = 0.0;
-
-    MTRand rng(1e9 + 7);
+// Builds the single-slot schedule of 'links', already sorted by priority key
+Solution constructSlot(const vector<vector<double>>& links, vector<double>& variables){
+    Solution sol (vector<TimeSlot>(1, slotTemplate));
+    double totalUsed = 0.0;
 
     int i = 0;
-    if(type == 0 || type == 1 || type == 3){
+    if(type == 0 || type == 1 || type == 3 || type == 4){
         while(i < links.size() && totalUsed < totalSpectrum){
             int connection = links[i][1]/2;
             int band = convertBand(variables[links[i][1]+1]);
@@ -432,20 +620,6 @@ double Solution::decode(vector<double>& variables) const {
             insertBestFree(sol, connection, band, variables);
             i++;
         } 
-
-        if(type == 1 || (type == 3 && refine)){
-            sol = dp(sol, rng);
-            // variables = rebuildChromossome(sol, n);
-            // vector<double> new_var = rebuildChromossome(sol, n);
-            /* Solution temp = verify(new_var);
-            if(temp.throughput == sol.throughput) cout << "IGUAL" << endl;
-            else{
-
-                cout << "DIFERENTE" << endl;
-                cout << temp.throughput << " " << sol.throughput << endl;
-            } */
-        }
-        
     } else if(type == 2) {
         while(i < links.size() && totalUsed < totalSpectrum){
             int connection = links[i][1]/2;
@@ -460,10 +634,120 @@ double Solution::decode(vector<double>& variables) const {
         } 
         
         sol = applyFusion(sol);
-    } else {
-        
     }
 
+    return sol;
+}
+
+// The priority gene doubles as the slot gene: [0,1) is cut into nSlots equal ranges
+int slotOf(double key){
+    return min(nSlots - 1, int(key * nSlots));
+}
+
+Solution build(vector<double>& variables, bool refined){
+    int n = variables.size();
+
+    vector<vector<double>> links(n/2);
+
+    for(int i = 0; i < n; i+=2){
+        double k1 = variables[i];
+        links[i/2].push_back(k1); links[i/2].push_back(i);
+    }
+
+    sort(links.begin(), links.end());
+
+    vector<vector<vector<double>>> slotLinks(nSlots);
+    for(const auto& link : links) slotLinks[slotOf(link[0])].pb(link);
+
+    // Slots share no link (and thus no band gene), so they are built independently. Inside the
+    // BRKGA decode loop this region is nested and runs on the calling thread only.
+    vector<Solution> slotSols(nSlots);
+    #pragma omp parallel for num_threads(nSlots) if(nSlots > 1)
+    for(int t = 0; t < nSlots; t++){
+        slotSols[t] = constructSlot(slotLinks[t], variables);
+        if(refined){
+            MTRand rng(1e9 + 7);
+            slotSols[t] = repack(dp(slotSols[t], rng));
+        }
+    }
+
+    Solution sol;
+    for(const auto& slotSol : slotSols){
+        sol.slots.pb(slotSol.slots[0]);
+        sol.throughput += slotSol.throughput;
+    }
+
+    return sol;
+}
+
+double Solution::decode(vector<double>& variables) const {
+    Solution sol = build(variables, type == 1 || (type == 3 && refine));
+
+    // variables = rebuildChromossome(sol, n);
+    // vector<double> new_var = rebuildChromossome(sol, n);
+    /* Solution temp = verify(new_var);
+    if(temp.throughput == sol.throughput) cout << "IGUAL" << endl;
+    else{
+
+        cout << "DIFERENTE" << endl;
+        cout << temp.throughput << " " << sol.throughput << endl;
+    } */
+
+    return -1.0 * sol.throughput;
+}
+
+// Cheap predictor of decode time, used by BRKGA to dispatch the longest decodes first. Links that
+// overflow into insertBestFree try every channel built so far, so each costs about as many
+// connection updates as links already placed in its slot; refinement roughly doubles the work.
+double Solution::cost(const vector<double>& variables) const {
+    int n = variables.size();
+
+    vector<pair<double, int>> links(n/2);
+    for(int i = 0; i < n; i+=2) links[i/2] = {variables[i], i};
+    sort(links.begin(), links.end());
+
+    vector<double> used(nSlots, 0.0), placed(nSlots, 0.0);
+    double estimate = 0.0;
+
+    for(const auto& link : links){
+        int t = slotOf(link.first);
+        if(used[t] < totalSpectrum){
+            used[t] += (type == 2) ? 20 : convertBand(variables[link.second + 1]);
+            estimate += 1.0;
+        } else {
+            estimate += placed[t];
+        }
+        placed[t]++;
+    }
+
+    if(type == 1 || (type == 3 && refine)) estimate *= 2.0;
+
+    return estimate;
+}
+
+// Two chromosomes with the same link order, slot split and band choices decode to the same
+// solution; this rolling hash over (link, slot, band) in rank order identifies that class.
+unsigned long long Solution::signature(const vector<double>& variables) const {
+    int n = variables.size();
+
+    vector<pair<double, int>> links(n/2);
+    for(int i = 0; i < n; i+=2) links[i/2] = {variables[i], i};
+    sort(links.begin(), links.end());
+
+    unsigned long long hash = 0xcbf29ce484222325ull;
+    for(const auto& link : links){
+        // Type 2 fixes every channel at 20 MHz and ignores the band genes
+        unsigned long long band = (type == 2) ? 0 : bandIndex(convertBand(variables[link.second + 1]));
+        unsigned long long token = ((unsigned long long)link.second << 16) | (slotOf(link.first) << 2) | band;
+        hash = (hash ^ token) * 0x100000001b3ull;
+    }
+
+    return hash;
+}
+
+// Type 4 leaves dp() out of decode; BRKGA only calls this on the offspring that reach the elite.
+double Solution::intensify(vector<double>& variables) const {
+    Solution sol = build(variables, true);
 
     return -1.0 * sol.throughput;
-}
\ No newline at end of file
+}
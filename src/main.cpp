@@ -1,7 +1,6 @@
 #include "../include/common.h"
-#include "../include/brkga.h"
-#include "../include/decoder.h"
-#include "../include/MTRand.h"
+#include "../include/engine.h"
+#include "../include/cache.h"
 
 namespace fs = std::filesystem;
 
@@ -15,13 +14,70 @@ const unsigned p = 100;
 const double pe = 0.25;
 const double pm = 0.05;
 const double rhoe = 0.70;
-const unsigned K = 1;
 const unsigned MAXT = omp_get_max_threads();
-const unsigned X_INTVL = 100;
-const unsigned X_NUMBER = 2;
 const unsigned MAX_GENS = 1000;
 
-void init(const fs::path& instancePath, FILE **solutionFile, FILE **objectivesFile, FILE **timeFile, FILE **populationFile) {
+// Stopping criteria (0 ==> unused), set from the command line; a run stops at the first one met
+struct StopCriteria {
+    unsigned generations = MAX_GENS;
+    double seconds = 0;         // wall-clock budget
+    double target = 0;          // throughput to reach
+    ll evaluations = 0;         // decodes
+    unsigned stagnation = 0;    // generations without improving the best throughput
+};
+
+StopCriteria stop;
+
+unsigned checkpointInterval = 0;    // generations between checkpoints (0 ==> none)
+bool resume = false;                // continue from the checkpoint of each instance, if any
+string checkpointPath;              // set by init() for the current instance
+vector<vector<double>> warmStart;   // chromosomes to seed the initial populations with
+unsigned processes = 1;             // solver processes, one island each (see ProcessIslands)
+
+// One chromosome per line, as in solution.txt. Read up front: init() may clear the output directory
+void readChromosomes(const string& path) {
+    ifstream file(path);
+    if (!file) {
+        fprintf(stderr, "error opening warm start file %s\n", path.c_str());
+        exit(13);
+    }
+
+    string line;
+    while (getline(file, line)) {
+        istringstream values(line);
+        vector<double> chromosome;
+        for (double value; values >> value;) chromosome.pb(value);
+        if (!chromosome.empty()) warmStart.pb(chromosome);
+    }
+}
+
+// --generations=G --time=S --target=T --evals=E --stagnation=G --checkpoint=G --resume
+// --warm-start=FILE --processes=N --channel-cache[=shared] --path-relink=STEPS
+bool parseOption(const string& arg) {
+    if (arg == "--resume") return resume = true;
+    if (arg == "--channel-cache") return useChannelCache = true;   // off by default, see cache.h
+
+    size_t eq = arg.find('=');
+    if (arg.rfind("--", 0) != 0 || eq == string::npos) return false;
+
+    string name = arg.substr(2, eq - 2), value = arg.substr(eq + 1);
+    if (name == "generations") stop.generations = stoul(value);
+    else if (name == "time") stop.seconds = stod(value);
+    else if (name == "target") stop.target = stod(value);
+    else if (name == "evals") stop.evaluations = stoll(value);
+    else if (name == "stagnation") stop.stagnation = stoul(value);
+    else if (name == "checkpoint") checkpointInterval = stoul(value);
+    else if (name == "warm-start") readChromosomes(value);
+    else if (name == "processes") processes = max(1ul, stoul(value));
+    else if (name == "channel-cache" && value == "shared") useChannelCache = shareChannelCache = true;
+    else if (name == "path-relink") pathRelinkSteps = stoul(value);
+    else return false;
+
+    return true;
+}
+
+void init(const fs::path& instancePath, FILE **solutionFile, FILE **objectivesFile, FILE **timeFile, FILE **populationFile, FILE **restartsFile,
+          FILE **parametersFile) {
     if (!instancePath.empty()) {
         fprintf(stderr, "trying to open input file %s\n", instancePath.c_str());
         freopen(instancePath.c_str(), "r", stdin);
@@ -40,13 +96,15 @@ void init(const fs::path& instancePath, FILE **solutionFile, FILE **objectivesFi
 
     ostringstream oss; oss << (pe * 100); 
     string aux = oss.str();
+    if(nSlots > 1) aux += "_" + to_string(nSlots) + "ts";
     if(type == 0) outputDir = "../output/output_" + aux + '/' + to_string(nConnections);
     else if(type == 1) outputDir = "../output/output_dp_" + aux + '/' + to_string(nConnections);
     else if(type == 2) outputDir = "../output/output_fixed_dp_" + aux + '/' + to_string(nConnections);
     else if (type == 3) outputDir = "../output/output_random_dp_" + aux + '/' + to_string(nConnections);
+    else if (type == 4) outputDir = "../output/output_elite_dp_" + aux + '/' + to_string(nConnections);
 
     try {
-        if (fs::exists(outputDir) && first){
+        if (fs::exists(outputDir) && first && !resume){
             fs::remove_all(outputDir);
             first = false;
         }
@@ -62,6 +120,8 @@ void init(const fs::path& instancePath, FILE **solutionFile, FILE **objectivesFi
         exit(1);
     }
 
+    checkpointPath = outputDir + "/checkpoint.bin";
+
     string solFile = outputDir +  "/solution.txt";
     *solutionFile = fopen(solFile.c_str(), "a");
 
@@ -73,15 +133,63 @@ void init(const fs::path& instancePath, FILE **solutionFile, FILE **objectivesFi
 
     string popFile = outputDir + "/population.txt";
     *populationFile = fopen(popFile.c_str(), "a");
+
+    string rFile = outputDir + "/restarts.txt";
+    *restartsFile = fopen(rFile.c_str(), "a");
+
+    string parFile = outputDir + "/parameters.txt";
+    *parametersFile = fopen(parFile.c_str(), "a");
+}
+
+void writeRun(FILE *solutionFile, FILE *objectivesFile, FILE *timeFile, const vector<double>& best,
+              double fitness, ll evals, double timeToBest, double totalTime) {
+    if (solutionFile != nullptr) {
+        for (int i = 0; i < best.size(); i++) fprintf(solutionFile, "%lf ", best[i]);
+        fprintf(solutionFile, "\n");
+    } else {
+        cout << stderr << "solutionFile is null!" << endl; 
+        exit(13);
+    }
+
+    if (objectivesFile != nullptr) fprintf(objectivesFile, "%lf %lld %lf\n", -1.0 * fitness, evals, timeToBest);
+    else {
+        cout << stderr << "objectivesFiles is null!" << endl;  
+        exit(13);
+    }
+
+    if(timeFile != nullptr) fprintf(timeFile, "%lf\n", totalTime);
+    else {
+        cout << stderr << "timeFile is null!" << endl;
+        exit(13);
+    }
 }
 
 int main(int argc, char **argv) {
     if (argc < 2) {
-        cout << stderr << "Choose type: Classic - 0 | Classic DP - 1 | Fixed DP - 2" << endl;
+        cout << stderr << "Choose type: Classic - 0 | Classic DP - 1 | Fixed DP - 2 | Random DP - 3 | Elite DP - 4 [time slots]"
+             << " [--generations=G] [--time=S] [--target=T] [--evals=E] [--stagnation=G] [--checkpoint=G] [--resume] [--warm-start=FILE] [--processes=N]"
+             << " [--channel-cache[=shared]] [--path-relink=STEPS (0 = off)]" << endl;
         exit(1);
     }
 
     type = stod(argv[1]);
+    for (int a = 2; a < argc; a++) {
+        string arg = argv[a];
+        if (arg.rfind("--", 0) != 0) nSlots = max(1, stoi(arg));
+        else if (!parseOption(arg)) {
+            fprintf(stderr, "unknown option %s\n", arg.c_str());
+            exit(1);
+        }
+    }
+
+    // Migrants in flight between processes live in shared memory and would not be in any checkpoint
+    if (processes > 1 && (checkpointInterval > 0 || resume)) {
+        fprintf(stderr, "--checkpoint and --resume cannot be combined with --processes\n");
+        exit(1);
+    }
+
+    // Islands fork after each loadData(), so the instance must already live in shared memory
+    if (processes > 1) shareInstance();
 
     const fs::path instancesDir = "../instances";
 
@@ -89,45 +197,111 @@ int main(int argc, char **argv) {
     int i = 0;
     for (const auto& entry : fs::directory_iterator(instancesDir)) {
         if (entry.is_regular_file() && entry.path().extension() == ".txt") {
-            FILE *solutionFile = nullptr,  *objectivesFile = nullptr, *timeFile = nullptr, *populationFile = nullptr;
+            FILE *solutionFile = nullptr,  *objectivesFile = nullptr, *timeFile = nullptr, *populationFile = nullptr, *restartsFile = nullptr;
+            FILE *parametersFile = nullptr;
 
-            init(entry.path(), &solutionFile, &objectivesFile, &timeFile, &populationFile);
+            init(entry.path(), &solutionFile, &objectivesFile, &timeFile, &populationFile, &restartsFile, &parametersFile);
             evaluations = 0;
             const unsigned n = numberVariables;
 
+            unsigned long seed = prime_numbers[i]; i++;
+
+            // With several processes, this one only coordinates: every island runs the code below
+            unique_ptr<ProcessIslands> islands;
+            int island = -1;
+            if (processes > 1) {
+                const auto start = chrono::steady_clock::now();
+                islands = make_unique<ProcessIslands>(processes, n, X_NUMBER);
+                island = islands->spawn();
+
+                if (island < 0) {
+                    int best = islands->wait();
+                    double total = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+                    if (best < 0) {
+                        fprintf(stderr, "every island failed on %s\n", entry.path().c_str());
+                        exit(13);
+                    }
+
+                    ll evals = 0;
+                    for (unsigned w = 0; w < processes; w++) evals += islands->evaluations(w);
+                    fprintf(stderr, "best of %u islands: %.1f (island %d)\n", processes, -islands->fitness(best), best);
+                    writeRun(solutionFile, objectivesFile, timeFile, islands->chromosome(best), islands->fitness(best),
+                             evals, islands->timeToBest(best), total);
+
+                    fclose(solutionFile);
+                    fclose(objectivesFile);
+                    fclose(timeFile);
+                    fclose(populationFile);
+                    if (restartsFile != nullptr) fclose(restartsFile);
+                    if (parametersFile != nullptr) fclose(parametersFile);
+                    continue;
+                }
+
+                // The coordinator owns the output files
+                populationFile = restartsFile = parametersFile = nullptr;
+            }
+
             Solution decoder;
-            MTRand rng(prime_numbers[i]); i++;
-            BRKGA<Solution, MTRand> algorithm(n, p, pe, pm, rhoe, decoder, rng, K, MAXT);
+            MTRand rng(seed + 7919 * max(island, 0));
+            Engine algorithm(n, p, pe, pm, rhoe, decoder, rng, K, islands ? islands->threads() : MAXT);
+            EliteArchive archive(n, ARCHIVE_SIZE);
+            configureEngine(algorithm, &archive);
             double TempoExecTotal = 0.0, TempoFO_Star = 0.0, FO_Star = 1000000007, FO_Min = -1000000007;
             int bestGeneration = 0, minGeneration = 0;
             int iterSemMelhora, iterMax = 10, quantIteracoes = 0, bestIteration = 0;
 
-            clock_t TempoFO_StarInic;
-
-            TempoFO_StarInic = clock();
+            // Wall time: clock() would add up the CPU time of every OpenMP thread. After --resume it
+            // also counts the segments before (saved in the checkpoint), so --time bounds the whole run
+            const auto TempoFO_StarInic = chrono::steady_clock::now();
+            double resumedTime = 0.0;
+            auto elapsed = [&TempoFO_StarInic, &resumedTime]() {
+                return resumedTime + chrono::duration<double>(chrono::steady_clock::now() - TempoFO_StarInic).count();
+            };
 
             bestGeneration = 0;
             minGeneration = 0;
 
             iterSemMelhora = 0;
-            iterMax = 1;
+            iterMax = RESTART_AFTER;
 
             quantIteracoes = 0;
             bestIteration = 0;
 
             unsigned generation = 0;
-            const auto DURATION_LIMIT = std::chrono::minutes(5);
+            const char *stopReason = "generations";
 
-            // while (std::chrono::steady_clock::now() - startTime < DURATION_LIMIT) {
-            for(int i = 0; i < 1000; i++){
-                refine = (rng.randInt(1) == 1);
-                
-                algorithm.evolve();
+            if (unsigned seeded = seedEngine(algorithm, warmStart)) {
+                FO_Star = algorithm.getBestFitness();
+                fprintf(stderr, "seeded %u chromosomes, best %.1f\n", seeded, -FO_Star);
+            }
+
+            if (resume && fs::exists(checkpointPath)) {
+                vector<double> saved;   // see saveCheckpoint below
+                algorithm.loadCheckpoint(checkpointPath, &saved);
+                generation = algorithm.getGeneration();
+                FO_Star = algorithm.getBestFitness();
+                if (saved.size() == 4) {
+                    resumedTime += saved[0] - elapsed();    // the setup redone before loading is not counted
+                    TempoFO_Star = saved[1];
+                    bestGeneration = saved[2];
+                    iterSemMelhora = saved[3];
+                }
+                fprintf(stderr, "resumed from %s at generation %u\n", checkpointPath.c_str(), generation);
+            }
+
+            while (true) {
+                if (generation >= stop.generations) { stopReason = "generations"; break; }
+                if (stop.seconds > 0 && elapsed() >= stop.seconds) { stopReason = "time"; break; }
+                if (stop.target > 0 && -FO_Star >= stop.target) { stopReason = "target"; break; }
+                if (stop.evaluations > 0 && evaluations >= stop.evaluations) { stopReason = "evaluations"; break; }
+                if (stop.stagnation > 0 && iterSemMelhora >= (int) stop.stagnation) { stopReason = "stagnation"; break; }
+
+                evolveEngine(algorithm, rng);
 
                 if (populationFile != nullptr) {
                     // Assume K=0 (apenas uma população ou a principal)
-                    // Itera sobre todos os indivíduos (tamanho p)
-                    for(unsigned k = 0; k < p; k++) {
+                    // Itera sobre todos os indivíduos (tamanho p, que pode variar entre gerações)
+                    for(unsigned k = 0; k < algorithm.getP(); k++) {
                         // Obtém o fitness. Multiplica por -1.0 para obter o Throughput real
                         double val = -1.0 * algorithm.getPopulationFitness(0, k);
                         fprintf(populationFile, "%lf ", val);
@@ -135,47 +309,87 @@ int main(int argc, char **argv) {
                     fprintf(populationFile, "\n"); // Nova linha = Nova geração
                 }
 
-                if ((++generation) % X_INTVL == 0) {
-                    algorithm.exchangeElite(X_NUMBER);
+                // One line per generation: generation, p, rhoe, mutant share, diversity, elite success rate
+                if (parametersFile != nullptr && !STEADY_STATE && PARAMETER_CONTROL) {
+                    const GenerationStats& stats = algorithm.getParameterLog().back();
+                    fprintf(parametersFile, "%u %u %.4lf %.4lf %.4lf %.4lf\n", stats.generation, stats.p, stats.rhoe,
+                            stats.pm, stats.diversity, stats.success);
                 }
 
+                if ((++generation) % X_INTVL == 0) exchangeEngine(algorithm, islands.get());
+
                 if (algorithm.getBestFitness() < FO_Star) {
-                    TempoFO_Star = (((double)(clock() - TempoFO_StarInic)) / CLOCKS_PER_SEC);
+                    TempoFO_Star = elapsed();
                     FO_Star = algorithm.getBestFitness();
                     bestGeneration = generation;
                     bestIteration = quantIteracoes; 
+                    iterSemMelhora = 0;
+                } else {
+                    iterSemMelhora++;
                 }
+
+                // At the end of the generation, so a resumed run repeats nothing
+                if (checkpointInterval > 0 && generation % checkpointInterval == 0)
+                    algorithm.saveCheckpoint(checkpointPath, {elapsed(), TempoFO_Star, double(bestGeneration),
+                                                              double(iterSemMelhora)});
                 
             }
-            // }
 
-            TempoExecTotal = (((double)(clock() - TempoFO_StarInic)) / CLOCKS_PER_SEC);
-
-            if (solutionFile != nullptr) {
-                vector<double> best = algorithm.getBestChromosome();
-                for (int i = 0; i < best.size(); i++) fprintf(solutionFile, "%lf ", best[i]);
-                fprintf(solutionFile, "\n");
-            } else {
-                cout << stderr << "solutionFile is null!" << endl; 
-                exit(13);
+            TempoExecTotal = elapsed();
+            fprintf(stderr, "stopped by %s after %u generations, %.1fs; best %.1f at %.1fs (generation %d)\n",
+                    stopReason, generation, TempoExecTotal, -FO_Star, TempoFO_Star, bestGeneration);
+
+            double busy = 0.0, idle = 0.0;
+            for (double t : algorithm.getBusyTime()) busy += t;
+            for (double t : algorithm.getIdleTime()) idle += t;
+            fprintf(stderr, "decode threads: %.1fs busy, %.1fs idle (%.1f%% utilization)\n",
+                    busy, idle, busy + idle > 0 ? 100.0 * busy / (busy + idle) : 0.0);
+
+            unsigned long long duplicates = 0;
+            for (unsigned k = 0; k < K; k++) duplicates += algorithm.getTotalDuplicates(k);
+            fprintf(stderr, "duplicates: %llu offspring re-mutated before decoding (%.2f per generation)\n",
+                    duplicates, double(duplicates) / max(1u, generation));
+
+            CacheStats cacheStats = channelCacheStats();
+            if (useChannelCache)
+                fprintf(stderr, "channel cache: %.1f%% hits (%lld local, %lld shared, %lld misses)\n",
+                        100.0 * cacheStats.hitRate(), cacheStats.hits, cacheStats.sharedHits, cacheStats.misses);
+
+            if (!algorithm.getResizes().empty())
+                fprintf(stderr, "population size: %u -> %u (%zu changes)\n", p, algorithm.getP(),
+                        algorithm.getResizes().size());
+
+            if (PARAMETER_CONTROL)
+                fprintf(stderr, "parameters: rhoe %.2f -> %.2f, pm %.2f -> %.2f\n", rhoe, algorithm.getRhoe(), pm,
+                        double(algorithm.getPm()) / algorithm.getP());
+
+            vector<ArchiveEntry> elite = archive.top(ARCHIVE_SIZE);
+            if (!elite.empty())
+                fprintf(stderr, "elite archive: %zu distinct solutions from %.1f to %.1f (%llu accepted)\n",
+                        elite.size(), -elite.front().fitness, -elite.back().fitness, archive.getAccepted());
+
+            if (islands) {
+                islands->publish(algorithm.getBestFitness(), algorithm.getBestChromosome(), evaluations, TempoFO_Star);
+                fflush(stderr);
+                _exit(0);   // leave the coordinator's files and shared segments alone
             }
 
-            if (objectivesFile != nullptr) fprintf(objectivesFile, "%lf %lld\n", -1.0 * algorithm.getBestFitness(), evaluations);
-            else {
-                cout << stderr << "objectivesFiles is null!" << endl;  
-                exit(13);
-            }
+            writeRun(solutionFile, objectivesFile, timeFile, algorithm.getBestChromosome(), algorithm.getBestFitness(),
+                     evaluations, TempoFO_Star, TempoExecTotal);
 
-            if(timeFile != nullptr) fprintf(timeFile, "%lf\n", TempoExecTotal);
-            else {
-                cout << stderr << "timeFile is null!" << endl;
-                exit(13);
+            // One line per restart: generation and best throughput kept across it
+            if (restartsFile != nullptr) {
+                for (const RestartEvent& event : algorithm.getRestarts())
+                    fprintf(restartsFile, "%u %lf\n", event.generation, -1.0 * event.bestFitness);
+                fprintf(restartsFile, "\n");
             }
 
             fclose(solutionFile);
             fclose(objectivesFile);
             fclose(timeFile);
             fclose(populationFile);
+            if (restartsFile != nullptr) fclose(restartsFile);
+            if (parametersFile != nullptr) fclose(parametersFile);
         }
 
     }
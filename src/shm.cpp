@@ -0,0 +1,287 @@
+#include "../include/shm.h"
+#include <fcntl.h>
+#include <sched.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <omp.h>
+
+namespace {
+
+atomic<unsigned> segments(0);
+
+size_t roundUp(size_t bytes, size_t alignment) {
+    return (bytes + alignment - 1) / alignment * alignment;
+}
+
+void fail(const string& what) {
+    throw runtime_error(what + ": " + strerror(errno));
+}
+
+const size_t MATRIX_BYTES = sizeof(double) * MAX_CONN * MAX_CONN;
+
+SharedSegment* instanceSegment = nullptr;
+
+// Room for a few migrations in flight before a slow island starts dropping migrants
+unsigned ringCapacity(unsigned migrants) {
+    unsigned capacity = 1;
+    while (capacity < 4 * migrants) capacity <<= 1;
+    return capacity;
+}
+
+}
+
+SharedSegment::SharedSegment(size_t _bytes) : memory(nullptr), bytes(_bytes) {
+    const string name = "/m3sp." + to_string(getpid()) + "." + to_string(segments++);
+
+    int fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+    if (fd < 0) fail("shm_open " + name);
+
+    if (ftruncate(fd, bytes) != 0) {
+        close(fd);
+        shm_unlink(name.c_str());
+        fail("ftruncate " + name);
+    }
+
+    void* mapped = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+
+    // Forked processes inherit the mapping, so the name is not needed past this point: dropping
+    // it now leaves nothing behind in /dev/shm however the processes end
+    int error = errno;
+    shm_unlink(name.c_str());
+    errno = error;
+    if (mapped == MAP_FAILED) fail("mmap " + name);
+
+    memory = static_cast<char*>(mapped);
+}
+
+SharedSegment::~SharedSegment() {
+    munmap(memory, bytes);
+}
+
+void shareInstance() {
+    if (instanceSegment != nullptr) return;
+
+    instanceSegment = new SharedSegment(3 * MATRIX_BYTES);
+    char* base = instanceSegment->data();
+    distanceMatrix = reinterpret_cast<double (*)[MAX_CONN]>(base);
+    interferenceMatrix = reinterpret_cast<double (*)[MAX_CONN]>(base + MATRIX_BYTES);
+    affectance = reinterpret_cast<double (*)[MAX_CONN]>(base + 2 * MATRIX_BYTES);
+}
+
+void protectInstance() {
+    if (instanceSegment == nullptr) return;
+    if (mprotect(instanceSegment->data(), instanceSegment->size(), PROT_READ) != 0) fail("mprotect");
+}
+
+// ---------------------------------------------------------------------------------------------
+
+struct ChromosomeRing::Header {
+    alignas(64) atomic<unsigned long long> enqueue;
+    alignas(64) atomic<unsigned long long> dequeue;
+};
+
+struct ChromosomeRing::Cell {
+    atomic<unsigned long long> sequence;
+    double fitness;
+    // followed by n alleles
+};
+
+static_assert(atomic<unsigned long long>::is_always_lock_free, "shared rings need address-free atomics");
+
+size_t ChromosomeRing::bytes(unsigned capacity, unsigned n) {
+    return sizeof(Header) + size_t(capacity) * roundUp(sizeof(Cell) + n * sizeof(double), 64);
+}
+
+ChromosomeRing::ChromosomeRing(char* memory, unsigned _capacity, unsigned _n, bool initialize)
+    : header(reinterpret_cast<Header*>(memory)), cells(memory + sizeof(Header)), capacity(_capacity),
+      n(_n), cellBytes(roundUp(sizeof(Cell) + _n * sizeof(double), 64)) {
+    if (capacity == 0 || (capacity & (capacity - 1)) != 0)
+        throw range_error("ChromosomeRing capacity must be a power of two.");
+
+    if (initialize) {
+        new (header) Header();
+        header->enqueue.store(0, memory_order_relaxed);
+        header->dequeue.store(0, memory_order_relaxed);
+        for (unsigned i = 0; i < capacity; i++) {
+            Cell* c = new (cells + i * cellBytes) Cell();
+            c->sequence.store(i, memory_order_relaxed);
+        }
+        atomic_thread_fence(memory_order_release);
+    }
+}
+
+ChromosomeRing::Cell* ChromosomeRing::cell(unsigned long long position) const {
+    return reinterpret_cast<Cell*>(cells + (position & (capacity - 1)) * cellBytes);
+}
+
+bool ChromosomeRing::push(double fitness, const double* chromosome) {
+    unsigned long long position = header->enqueue.load(memory_order_relaxed);
+    Cell* c;
+    while (true) {
+        c = cell(position);
+        unsigned long long sequence = c->sequence.load(memory_order_acquire);
+        long long diff = (long long) sequence - (long long) position;
+
+        if (diff == 0) {
+            if (header->enqueue.compare_exchange_weak(position, position + 1, memory_order_relaxed)) break;
+        } else if (diff < 0) {
+            return false;   // full
+        } else {
+            position = header->enqueue.load(memory_order_relaxed);
+        }
+    }
+
+    c->fitness = fitness;
+    memcpy(reinterpret_cast<char*>(c) + sizeof(Cell), chromosome, n * sizeof(double));
+    c->sequence.store(position + 1, memory_order_release);
+    return true;
+}
+
+bool ChromosomeRing::pop(double& fitness, double* chromosome) {
+    unsigned long long position = header->dequeue.load(memory_order_relaxed);
+    Cell* c;
+    while (true) {
+        c = cell(position);
+        unsigned long long sequence = c->sequence.load(memory_order_acquire);
+        long long diff = (long long) sequence - (long long) (position + 1);
+
+        if (diff == 0) {
+            if (header->dequeue.compare_exchange_weak(position, position + 1, memory_order_relaxed)) break;
+        } else if (diff < 0) {
+            return false;   // empty
+        } else {
+            position = header->dequeue.load(memory_order_relaxed);
+        }
+    }
+
+    fitness = c->fitness;
+    memcpy(chromosome, reinterpret_cast<char*>(c) + sizeof(Cell), n * sizeof(double));
+    c->sequence.store(position + capacity, memory_order_release);
+    return true;
+}
+
+// ---------------------------------------------------------------------------------------------
+
+struct ProcessIslands::Result {
+    atomic<int> done;
+    double fitness;
+    ll evaluations;
+    double timeToBest;
+    // followed by n alleles
+};
+
+ProcessIslands::ProcessIslands(unsigned _processes, unsigned _n, unsigned migrants)
+    : processes(_processes), n(_n), capacity(ringCapacity(migrants)), islandThreads(1), island(-1),
+      ringBytes(roundUp(ChromosomeRing::bytes(capacity, _n), 64)),
+      resultBytes(roundUp(sizeof(Result) + _n * sizeof(double), 64)),
+      segment(_processes * (ringBytes + resultBytes)) {
+    for (unsigned i = 0; i < processes; i++) {
+        ring(i, true);
+        Result* r = new (result(i)) Result();
+        r->done.store(0, memory_order_relaxed);
+    }
+}
+
+ChromosomeRing ProcessIslands::ring(unsigned i, bool initialize) const {
+    return ChromosomeRing(segment.data() + i * ringBytes, capacity, n, initialize);
+}
+
+ProcessIslands::Result* ProcessIslands::result(unsigned i) const {
+    return reinterpret_cast<Result*>(segment.data() + processes * ringBytes + i * resultBytes);
+}
+
+int ProcessIslands::spawn() {
+    // The CPUs we may use are split into one contiguous block per island
+    cpu_set_t available;
+    CPU_ZERO(&available);
+    sched_getaffinity(0, sizeof(available), &available);
+
+    vector<int> cpus;
+    for (int c = 0; c < CPU_SETSIZE; c++)
+        if (CPU_ISSET(c, &available)) cpus.pb(c);
+
+    fflush(nullptr);    // children must not flush the coordinator's buffered output again
+
+    for (unsigned i = 0; i < processes; i++) {
+        pid_t pid = fork();
+        if (pid < 0) fail("fork");
+
+        if (pid == 0) {
+            island = i;
+
+            size_t first = i * cpus.size() / processes, last = (i + 1) * cpus.size() / processes;
+            if (last == first) first = i % cpus.size(), last = first + 1;   // more islands than CPUs
+
+            cpu_set_t mine;
+            CPU_ZERO(&mine);
+            for (size_t c = first; c < last; c++) CPU_SET(cpus[c], &mine);
+            sched_setaffinity(0, sizeof(mine), &mine);
+
+            islandThreads = last - first;
+            omp_set_num_threads(islandThreads);
+            protectInstance();
+            return island;
+        }
+
+        children.pb(pid);
+    }
+
+    return -1;
+}
+
+void ProcessIslands::send(double fitness, const double* chromosome) {
+    // A full ring means the next island is behind: dropping the migrant beats blocking
+    ring((island + 1) % processes).push(fitness, chromosome);
+}
+
+vector<pair<double, vector<double>>> ProcessIslands::receive() {
+    vector<pair<double, vector<double>>> migrants;
+    ChromosomeRing inbox = ring(island);
+
+    double fitness;
+    vector<double> chromosome(n);
+    while (inbox.pop(fitness, chromosome.data())) migrants.pb({fitness, chromosome});
+
+    return migrants;
+}
+
+void ProcessIslands::publish(double fitness, const vector<double>& chromosome, ll evaluations, double timeToBest) {
+    Result* r = result(island);
+    r->fitness = fitness;
+    r->evaluations = evaluations;
+    r->timeToBest = timeToBest;
+    memcpy(reinterpret_cast<char*>(r) + sizeof(Result), chromosome.data(), n * sizeof(double));
+    r->done.store(1, memory_order_release);
+}
+
+int ProcessIslands::wait() {
+    int best = -1;
+    for (unsigned i = 0; i < children.size(); i++) {
+        int status = 0;
+        while (waitpid(children[i], &status, 0) < 0 && errno == EINTR) {}
+
+        if (WIFSIGNALED(status))
+            fprintf(stderr, "island %u killed by signal %d\n", i, WTERMSIG(status));
+        else if (WEXITSTATUS(status) != 0)
+            fprintf(stderr, "island %u exited with status %d\n", i, WEXITSTATUS(status));
+
+        if (result(i)->done.load(memory_order_acquire) && (best < 0 || fitness(i) < fitness(best))) best = i;
+    }
+    children.clear();
+
+    return best;
+}
+
+double ProcessIslands::fitness(int i) const { return result(i)->fitness; }
+
+ll ProcessIslands::evaluations(int i) const { return result(i)->evaluations; }
+
+double ProcessIslands::timeToBest(int i) const { return result(i)->timeToBest; }
+
+vector<double> ProcessIslands::chromosome(int i) const {
+    const double* genes = reinterpret_cast<const double*>(reinterpret_cast<const char*>(result(i)) + sizeof(Result));
+    return vector<double>(genes, genes + n);
+}
@@ -0,0 +1,254 @@
+// Racing tuner for the BRKGA hyperparameters (p, pe, pm, rhoe), in the spirit of F-race / irace.
+//
+// Every candidate configuration is run on a sequence of blocks, one block being an (instance,
+// seed) pair. A run records when its best throughput improves; once a block is done, each run is
+// scored by its time to reach the block target, a fixed gap below the best throughput any
+// surviving configuration found on that block (runs that never reach it score twice the budget).
+// After MIN_BLOCKS blocks, a Friedman test over the scores discards the configurations that are
+// significantly worse than the best one. Configurations of a block run in parallel, one thread
+// each, except for type 3: its runs flip the shared 'refine' flag every generation, so they run one
+// at a time, each with every thread.
+//
+// Runs are set up and driven by engine.h exactly as main does (intensification, adaptive size,
+// parameter control, restarts, path relinking, heuristic seeds...), so the winner is tuned for the
+// configuration main runs.
+//
+// Usage: ./tuner <type> [time slots] [seconds per run] [max blocks]
+// Build it like main.cpp, linking common.cpp, decoder.cpp, cache.cpp and shm.cpp (but not main.cpp).
+
+#include "../include/common.h"
+#include "../include/engine.h"
+
+namespace fs = std::filesystem;
+
+const double TARGET_GAP = 0.01;     // target: within 1% of the best throughput of the block
+const double ALPHA = 0.05;          // significance level of the Friedman test
+const unsigned MIN_BLOCKS = 5;      // blocks evaluated before the first elimination
+const unsigned MAX_GENS = 1000;     // cap on generations per run, besides the time budget
+
+struct Config {
+    unsigned p;
+    double pe, pm, rhoe;
+};
+
+// Improvements of the best throughput of one run: (seconds since start, throughput)
+typedef vector<pair<double, double>> Trajectory;
+
+Trajectory run(const Config& config, unsigned long seed, double budget, unsigned threads) {
+    Solution decoder;
+    MTRand rng(seed);
+
+    auto start = chrono::steady_clock::now();
+    auto elapsed = [&start]() { return chrono::duration<double>(chrono::steady_clock::now() - start).count(); };
+
+    const unsigned n = 2 * nConnections;
+    Engine algorithm(n, config.p, config.pe, config.pm, config.rhoe, decoder, rng, K, threads);
+    EliteArchive archive(n, ARCHIVE_SIZE);
+    configureEngine(algorithm, &archive);
+    seedEngine(algorithm, vector<vector<double>>());
+    Trajectory trajectory(1, {elapsed(), -algorithm.getBestFitness()});
+
+    for (unsigned g = 0; g < MAX_GENS && elapsed() < budget; g++) {
+        evolveEngine(algorithm, rng);
+        if ((g + 1) % X_INTVL == 0) exchangeEngine(algorithm, nullptr);
+
+        double best = -algorithm.getBestFitness();
+        if (best > trajectory.back().ss) trajectory.pb({elapsed(), best});
+    }
+
+    return trajectory;
+}
+
+double timeToTarget(const Trajectory& trajectory, double target, double budget) {
+    for (const auto& point : trajectory)
+        if (point.ss >= target) return point.ff;
+    return 2 * budget;
+}
+
+// Quantile of the standard normal distribution (Acklam's rational approximation)
+double normalQuantile(double q) {
+    static const double a[] = {-3.969683028665376e+01, 2.209460984245205e+02, -2.759285104469687e+02,
+                               1.383577518672690e+02, -3.066479806614716e+01, 2.506628277459239e+00};
+    static const double b[] = {-5.447609879822406e+01, 1.615858368580409e+02, -1.556989798598866e+02,
+                               6.680131188771972e+01, -1.328068155288572e+01};
+    static const double c[] = {-7.784894002430293e-03, -3.223964580411365e-01, -2.400758277161838e+00,
+                               -2.549732539343734e+00, 4.374664141464968e+00, 2.938163982698783e+00};
+    static const double d[] = {7.784695709041462e-03, 3.224671290700398e-01, 2.445134137142996e+00,
+                               3.754408661907416e+00};
+
+    if (q < 0.02425) {
+        double r = sqrt(-2 * log(q));
+        return (((((c[0]*r + c[1])*r + c[2])*r + c[3])*r + c[4])*r + c[5]) /
+               ((((d[0]*r + d[1])*r + d[2])*r + d[3])*r + 1);
+    }
+    if (q > 1 - 0.02425) return -normalQuantile(1 - q);
+
+    double r = q - 0.5, s = r * r;
+    return (((((a[0]*s + a[1])*s + a[2])*s + a[3])*s + a[4])*s + a[5])*r /
+           (((((b[0]*s + b[1])*s + b[2])*s + b[3])*s + b[4])*s + 1);
+}
+
+// Wilson-Hilferty approximation of the chi-square quantile
+double chiSquareQuantile(double q, double df) {
+    double z = normalQuantile(q), h = 2.0 / (9.0 * df);
+    return df * pow(1 - h + z * sqrt(h), 3);
+}
+
+// Cornish-Fisher expansion of the Student t quantile
+double studentQuantile(double q, double df) {
+    double z = normalQuantile(q), z3 = z * z * z, z5 = z3 * z * z;
+    return z + (z3 + z) / (4 * df) + (5 * z5 + 16 * z3 + 3 * z) / (96 * df * df);
+}
+
+// Ranks of 'values' (1 = smallest), ties sharing their average rank
+vector<double> rankValues(const vector<double>& values) {
+    int k = values.size();
+    vector<int> order(k);
+    iota(order.begin(), order.end(), 0);
+    sort(order.begin(), order.end(), [&values](int a, int b) { return values[a] < values[b]; });
+
+    vector<double> ranks(k);
+    for (int i = 0; i < k;) {
+        int j = i;
+        while (j + 1 < k && values[order[j + 1]] == values[order[i]]) j++;
+        for (int t = i; t <= j; t++) ranks[order[t]] = (i + j) / 2.0 + 1;
+        i = j + 1;
+    }
+
+    return ranks;
+}
+
+// Friedman test with Conover's post-hoc comparison against the best configuration, as in F-race.
+// scores[b][j] is the score of configuration j on block b (lower is better). Returns the indices
+// of the configurations that survive.
+vector<int> race(const vector<vector<double>>& scores) {
+    int b = scores.size(), k = scores[0].size();
+    vector<int> survivors(k);
+    iota(survivors.begin(), survivors.end(), 0);
+    if (k < 2) return survivors;
+
+    vector<double> rankSums(k, 0.0);
+    double A = 0.0;
+    for (const auto& block : scores) {
+        vector<double> ranks = rankValues(block);
+        for (int j = 0; j < k; j++) {
+            rankSums[j] += ranks[j];
+            A += ranks[j] * ranks[j];
+        }
+    }
+
+    double C = b * k * (k + 1.0) * (k + 1.0) / 4.0;
+    if (A - C < EPS) return survivors;  // every block tied
+
+    double sumSquares = 0.0;
+    for (double R : rankSums) sumSquares += R * R;
+    double T = (k - 1) * (sumSquares - b * C) / (A - C);
+
+    if (T <= chiSquareQuantile(1 - ALPHA, k - 1)) return survivors;
+
+    int best = min_element(rankSums.begin(), rankSums.end()) - rankSums.begin();
+    double df = (b - 1.0) * (k - 1.0);
+    double se = sqrt(2 * b * max(0.0, 1 - T / (b * (k - 1.0))) * (A - C) / df);
+    double critical = studentQuantile(1 - ALPHA / 2, df) * se;
+
+    survivors.clear();
+    for (int j = 0; j < k; j++)
+        if (j == best || fabs(rankSums[j] - rankSums[best]) <= critical) survivors.pb(j);
+
+    return survivors;
+}
+
+int main(int argc, char **argv) {
+    if (argc < 2) {
+        cout << stderr << "Choose type: Classic - 0 | Classic DP - 1 | Fixed DP - 2 | Random DP - 3 | Elite DP - 4 [time slots] [seconds per run] [max blocks]" << endl;
+        exit(1);
+    }
+
+    type = stod(argv[1]);
+    if (argc > 2) nSlots = max(1, stoi(argv[2]));
+    double budget = (argc > 3) ? stod(argv[3]) : 10.0;
+    unsigned maxBlocks = (argc > 4) ? stoi(argv[4]) : 30;
+    const bool serial = (type == 3);   // see above
+    const unsigned threads = serial ? omp_get_max_threads() : 1;
+
+    vector<fs::path> instances;
+    for (const auto& entry : fs::directory_iterator("../instances"))
+        if (entry.is_regular_file() && entry.path().extension() == ".txt") instances.pb(entry.path());
+    sort(instances.begin(), instances.end());
+
+    if (instances.empty()) {
+        fprintf(stderr, "no instances found in ../instances\n");
+        exit(13);
+    }
+
+    vector<Config> candidates;
+    for (unsigned p : {100u, 200u})
+        for (double pe : {0.10, 0.20, 0.25})
+            for (double pm : {0.05, 0.10, 0.15})
+                for (double rhoe : {0.60, 0.70, 0.80})
+                    candidates.pb({p, pe, pm, rhoe});
+
+    vector<unsigned long> seeds = {2, 3, 5, 7, 11, 13, 17, 19, 23, 29};
+    vector<int> alive(candidates.size());
+    iota(alive.begin(), alive.end(), 0);
+
+    // scores[b][c]: score of candidate c on block b (only read for the candidates still alive)
+    vector<vector<double>> scores;
+
+    for (unsigned block = 0; block < maxBlocks && alive.size() > 1; block++) {
+        const fs::path& instance = instances[block % instances.size()];
+        unsigned long seed = seeds[(block / instances.size()) % seeds.size()] + block / (instances.size() * seeds.size());
+
+        freopen(instance.c_str(), "r", stdin);
+        loadData();
+
+        vector<Trajectory> trajectories(alive.size());
+        #pragma omp parallel for schedule(dynamic, 1) if(!serial)
+        for (int c = 0; c < (int) alive.size(); c++)
+            trajectories[c] = run(candidates[alive[c]], seed, budget, threads);
+
+        double best = 0.0;
+        for (const auto& trajectory : trajectories) best = max(best, trajectory.back().ss);
+        double target = (1 - TARGET_GAP) * best;
+
+        scores.pb(vector<double>(candidates.size(), 0.0));
+        for (int c = 0; c < (int) alive.size(); c++)
+            scores.back()[alive[c]] = timeToTarget(trajectories[c], target, budget);
+
+        fprintf(stderr, "block %u (%s, seed %lu): target %.1f, %zu candidates\n",
+                block + 1, instance.filename().c_str(), seed, target, alive.size());
+
+        if (scores.size() < MIN_BLOCKS) continue;
+
+        vector<vector<double>> aliveScores;
+        for (const auto& blockScores : scores) {
+            aliveScores.pb({});
+            for (int c : alive) aliveScores.back().pb(blockScores[c]);
+        }
+
+        vector<int> survivors;
+        for (int j : race(aliveScores)) survivors.pb(alive[j]);
+        if (survivors.size() < alive.size())
+            fprintf(stderr, "  discarded %zu candidates\n", alive.size() - survivors.size());
+        alive = survivors;
+    }
+
+    // Best mean time-to-target among the survivors
+    int bestCandidate = alive[0];
+    double bestMean = LINF;
+    for (int c : alive) {
+        double mean = 0.0;
+        for (const auto& blockScores : scores) mean += blockScores[c];
+        mean /= scores.size();
+
+        const Config& config = candidates[c];
+        printf("p = %u, pe = %.2f, pm = %.2f, rhoe = %.2f: %.2fs mean time-to-target\n",
+               config.p, config.pe, config.pm, config.rhoe, mean);
+        if (mean < bestMean) bestMean = mean, bestCandidate = c;
+    }
+
+    const Config& config = candidates[bestCandidate];
+    printf("best: p = %u, pe = %.2f, pm = %.2f, rhoe = %.2f\n", config.p, config.pe, config.pm, config.rhoe);
+
+    return 0;
+}